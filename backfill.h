@@ -0,0 +1,166 @@
+#ifndef BACKFILL_H
+#define BACKFILL_H
+
+#include "candle_series.h"
+#include "coinbase.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Loads an arbitrary [start, end) range of history. Coinbase answers at most
+// 300 buckets per /candles call, so the range is split into chunks that are
+// downloaded in parallel through Coinbase::fetchMany under a request-rate
+// budget, then merged into one sorted, de-duplicated series. Failed chunks are
+// retried after an exponentially growing pause.
+class Backfill {
+public:
+  struct Options {
+    size_t bucketsPerChunk = 300;
+    size_t maxInFlight = 4;
+    double requestsPerSecond = 8.0; // stays under the public 10/s limit
+    int retries = 2;                // extra rounds for chunks that failed
+    std::chrono::milliseconds retryInitial{500}; // pause before the 1st retry
+    std::chrono::milliseconds retryMax{8000};
+    double backoff = 2.0;
+    // When set, checked between batches of chunks and during retry pauses;
+    // once it reads false the fetch stops with what has arrived.
+    const std::atomic<bool> *running = nullptr;
+  };
+
+  explicit Backfill(Coinbase &coinbase) : Backfill(coinbase, Options{}) {}
+  Backfill(Coinbase &coinbase, const Options &options)
+      : coinbase(coinbase), options(options) {}
+
+  // Splits [start, end) into request windows of at most bucketsPerChunk
+  // buckets. The API treats `end` as inclusive, hence the `- granularity`.
+  static std::vector<Coinbase::FetchRequest>
+  chunk(const std::string &product_id, int granularity, time_t start,
+        time_t end, size_t bucketsPerChunk = 300) {
+    std::vector<Coinbase::FetchRequest> requests;
+    if (granularity <= 0 || end <= start || bucketsPerChunk == 0) {
+      return requests;
+    }
+    start -= start % granularity;
+    const time_t span = static_cast<time_t>(bucketsPerChunk) * granularity;
+    for (time_t chunkStart = start; chunkStart < end; chunkStart += span) {
+      time_t chunkEnd = std::min(chunkStart + span, end) - granularity;
+      requests.push_back(
+          {product_id, granularity, chunkStart, std::max(chunkStart, chunkEnd)});
+    }
+    return requests;
+  }
+
+  // Appends every candle in [start, end) to `out`, oldest first and without
+  // duplicates. Returns false if some chunk still failed after the retries
+  // or the fetch was stopped; whatever did arrive is merged anyway.
+  bool fetch(const std::string &product_id, int granularity, time_t start,
+             time_t end, CandleSeries &out) {
+    std::vector<Coinbase::FetchRequest> pending =
+        chunk(product_id, granularity, start, end, options.bucketsPerChunk);
+    std::vector<CandleSeries> chunks;
+    chunks.reserve(pending.size());
+
+    coinbase.setRateLimit(options.requestsPerSecond);
+    // Chunks go out a few in-flight windows at a time so a stop request is
+    // seen between batches rather than after the whole range.
+    const size_t batchSize = std::max<size_t>(1, options.maxInFlight) * 2;
+    double delay = static_cast<double>(options.retryInitial.count());
+    for (int round = 0; round <= options.retries && !pending.empty();
+         ++round) {
+      if (round > 0) {
+        pause(std::chrono::milliseconds(static_cast<long long>(delay)));
+        delay = std::min(delay * options.backoff,
+                         static_cast<double>(options.retryMax.count()));
+      }
+      std::vector<Coinbase::FetchRequest> failed;
+      for (size_t first = 0; first < pending.size(); first += batchSize) {
+        if (stopped()) {
+          failed.insert(failed.end(), pending.begin() + first, pending.end());
+          break;
+        }
+        std::vector<Coinbase::FetchRequest> batch(
+            pending.begin() + first,
+            pending.begin() + std::min(first + batchSize, pending.size()));
+        std::vector<Coinbase::FetchResult> results =
+            coinbase.fetchMany(batch, options.maxInFlight);
+        for (auto &result : results) {
+          if (result.ok) {
+            chunks.push_back(std::move(result.candles));
+          } else {
+            std::cerr << "Backfill: chunk " << batch[result.index].start
+                      << " failed: " << result.error << std::endl;
+            failed.push_back(batch[result.index]);
+          }
+        }
+      }
+      pending.swap(failed);
+      if (stopped()) {
+        break;
+      }
+    }
+
+    merge(chunks, start, end, out);
+    return pending.empty();
+  }
+
+  // Merges chunk series (each oldest first) into `out`, keeping rows in
+  // [start, end) and dropping repeated timestamps.
+  static void merge(const std::vector<CandleSeries> &chunks, time_t start,
+                    time_t end, CandleSeries &out) {
+    struct Row {
+      time_t time;
+      size_t chunk;
+      size_t index;
+    };
+    std::vector<Row> rows;
+    size_t total = 0;
+    for (const auto &series : chunks) {
+      total += series.size();
+    }
+    rows.reserve(total);
+    for (size_t c = 0; c < chunks.size(); ++c) {
+      Span<time_t> times = chunks[c].time();
+      for (size_t i = 0; i < times.size(); ++i) {
+        if (times[i] >= start && times[i] < end) {
+          rows.push_back({times[i], c, i});
+        }
+      }
+    }
+    std::stable_sort(rows.begin(), rows.end(),
+                     [](const Row &a, const Row &b) { return a.time < b.time; });
+
+    out.reserve(out.size() + rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+      if (i > 0 && rows[i].time == rows[i - 1].time) {
+        continue;
+      }
+      if (!out.empty() && rows[i].time <= out.time().back()) {
+        continue; // already present in the caller's series
+      }
+      out.append(chunks[rows[i].chunk].at(rows[i].index));
+    }
+  }
+
+private:
+  bool stopped() const { return options.running && !options.running->load(); }
+
+  // Sleeps for `duration`, waking early once stopped.
+  void pause(std::chrono::milliseconds duration) const {
+    const auto deadline = std::chrono::steady_clock::now() + duration;
+    while (!stopped() && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+          deadline - std::chrono::steady_clock::now(),
+          std::chrono::milliseconds(100)));
+    }
+  }
+
+  Coinbase &coinbase;
+  Options options;
+};
+
+#endif // BACKFILL_H
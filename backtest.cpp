@@ -0,0 +1,95 @@
+// Headless backtest: replays cached candle history through the live signal
+// rule and reports the trades it would have made. Build with build.sh.
+//
+//   ./backtest [product] [granularity] [days] [cache_dir] [quote_increment]
+//
+// History comes from the candle store under cache_dir (default ./cache, the
+// same one the GUI fills); whatever the store lacks is backfilled first and
+// the new tail is cached for the next run. Trades are tallied in whole ticks
+// of quote_increment (default 0.01), so the PnL is exact and reproducible.
+
+#include "backtest.h"
+#include "candle_store.h"
+#include "operations.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+int main(int argc, char **argv) {
+  const std::string productId = argc > 1 ? argv[1] : "BTC-USD";
+  const int granularity = argc > 2 ? std::atoi(argv[2]) : 60;
+  const int days = argc > 3 ? std::atoi(argv[3]) : 365;
+  const std::string cacheDir = argc > 4 ? argv[4] : "cache";
+  QuoteIncrement increment;
+  if (granularity <= 0 || days <= 0 ||
+      !QuoteIncrement::parse(argc > 5 ? argv[5] : "0.01", increment)) {
+    std::cerr << "usage: backtest [product] [granularity] [days] [cache_dir] "
+                 "[quote_increment]"
+              << std::endl;
+    return 1;
+  }
+
+  // Only closed buckets: stop at the start of the current one.
+  time_t end = std::time(nullptr);
+  end -= end % granularity;
+  time_t start = end - static_cast<time_t>(days) * 24 * 60 * 60;
+
+  Operations operations;
+  CandleSeries series;
+  try {
+    CandleStore store(cacheDir, productId, granularity);
+    if (!Backtest::loadHistory(store, productId, granularity, start, end, series)) {
+      std::cerr << "Backtest: history incomplete, replaying what arrived"
+                << std::endl;
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "Backtest: " << e.what() << std::endl;
+    return 1;
+  }
+
+  Backtest backtest(IndicatorEngine::Periods{}, nullptr, increment);
+  Backtest::Report report = backtest.run(series);
+  if (report.candles == 0) {
+    std::cerr << "Backtest: no candles in range" << std::endl;
+    return 1;
+  }
+
+  std::printf("Product : %s  granularity %d s\n", productId.c_str(),
+              granularity);
+  std::printf("Range : %s - %s\n",
+              operations.convertToTimestamp(report.firstTime).c_str(),
+              operations.convertToTimestamp(report.lastTime).c_str());
+  std::printf("Candles : %zu (%zu evaluated) in %.3f s, %.0f candles/s\n",
+              report.candles, report.evaluated, report.seconds,
+              report.seconds > 0 ? report.candles / report.seconds : 0.0);
+  std::printf("Total buy decision : %d\n", report.stats.buyCount);
+  std::printf("Total sell decision : %d\n", report.stats.sellCount);
+  std::printf("Total successfull buy decision : %d\n",
+              report.stats.buySuccessCount);
+  std::printf("Total failed buy decision : %d\n", report.stats.buyFailCount);
+  std::printf("Total successfull sell decision : %d\n",
+              report.stats.sellSuccessCount);
+  std::printf("Total failed sell decision : %d\n",
+              report.stats.sellFailCount);
+
+  size_t wins = 0;
+  double best = 0.0;
+  double worst = 0.0;
+  for (const auto &trade : report.trades) {
+    wins += trade.pnl > 0;
+    best = std::max(best, trade.pnl);
+    worst = std::min(worst, trade.pnl);
+  }
+  std::printf("Trades : %zu  win rate %.1f%%\n", report.trades.size(),
+              report.trades.empty() ? 0.0
+                                    : 100.0 * wins / report.trades.size());
+  char pnl[32];
+  size_t n = increment.format(report.pnlTicks, pnl, sizeof(pnl) - 1);
+  pnl[n] = '\0';
+  std::printf("PnL per unit : %s  (best %.2f, worst %.2f)\n", pnl, best,
+              worst);
+  return 0;
+}
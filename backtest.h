@@ -0,0 +1,133 @@
+#ifndef BACKTEST_H
+#define BACKTEST_H
+
+#include "backfill.h"
+#include "candle_series.h"
+#include "candle_store.h"
+#include "fixed_price.h"
+#include "indicators.h"
+#include "signals.h"
+#include "strategy.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <vector>
+
+// Replays stored candles through the same indicator engine, strategy and
+// trade tally the live GUI uses, as fast as the CPU allows. Each candle is
+// treated as closed: the engine sees it, then the strategy judges it.
+class Backtest {
+public:
+  struct Report {
+    DecisionStats stats;
+    std::vector<TradeTally::Trade> trades;
+    double pnl = 0.0;
+    Ticks pnlTicks = 0; // exact PnL when a quote increment was given
+    size_t candles = 0;
+    size_t evaluated = 0; // candles judged once the engine was warm
+    std::time_t firstTime = 0;
+    std::time_t lastTime = 0;
+    double seconds = 0.0;
+  };
+
+  Backtest() : Backtest(IndicatorEngine::Periods{}) {}
+  // `strategy` must outlive the backtest; by default the live rule is used.
+  // With a quote increment the trades are tallied in exact ticks.
+  explicit Backtest(const IndicatorEngine::Periods &periods,
+                    const Strategy *strategy = nullptr,
+                    const QuoteIncrement &increment = {})
+      : periods(periods), strategy(strategy ? strategy : &defaultStrategy),
+        increment(increment) {}
+
+  // `series` must be oldest first.
+  Report run(const CandleSeries &series) const {
+    return replay(series.size(), [&series](size_t i) { return series.at(i); });
+  }
+
+  // Replays [start, end) straight from the memory map without a copy.
+  Report run(const CandleStore &store, std::time_t start,
+             std::time_t end) const {
+    const size_t first = store.lowerBound(start);
+    const size_t last = store.lowerBound(end);
+    return replay(last - first,
+                  [&store, first](size_t i) { return store.at(first + i); });
+  }
+
+  // Assembles [start, end) from the store plus the network. The store is
+  // append-only, so history older than its first row is fetched but not kept.
+  static bool loadHistory(CandleStore &store, const std::string &product_id,
+                          int granularity, time_t start, time_t end,
+                          CandleSeries &series) {
+    Coinbase coinbase;
+    Backfill backfill(coinbase);
+    bool complete = true;
+    time_t from = start;
+
+    if (!store.empty() && store.firstTime() > from) {
+      complete &= backfill.fetch(product_id, granularity, from,
+                                 std::min(store.firstTime(), end), series);
+      from = store.firstTime();
+    }
+    if (!store.empty() && store.coveredEnd() > from && from < end) {
+      store.range(from, end, series);
+      from = store.coveredEnd();
+    }
+    if (from < end) {
+      const bool fetched =
+          backfill.fetch(product_id, granularity, from, end, series);
+      complete &= fetched;
+      // Cache only a complete window of closed buckets that extends the
+      // store without leaving a hole.
+      const time_t now = std::time(nullptr);
+      const time_t closed = std::min(end, now - now % granularity);
+      if (fetched && from < closed &&
+          (store.coveredEnd() == 0 || from <= store.coveredEnd())) {
+        store.append(series, from, closed);
+      }
+    }
+    return complete;
+  }
+
+private:
+  template <typename CandleAt>
+  Report replay(size_t count, CandleAt candleAt) const {
+    const auto started = std::chrono::steady_clock::now();
+    IndicatorEngine engine(periods);
+    TradeTally tally(increment);
+    Report report;
+
+    for (size_t i = 0; i < count; ++i) {
+      const Candle candle = candleAt(i);
+      engine.update(candle);
+      if (!engine.ready()) {
+        continue;
+      }
+      tally.record(strategy->evaluate(engine, candle), candle.timestamp,
+                   candle.closingPrice);
+      ++report.evaluated;
+    }
+
+    report.stats = tally.stats();
+    report.trades = tally.trades();
+    report.pnl = tally.pnl();
+    report.pnlTicks = tally.pnlTicks();
+    report.candles = count;
+    if (count > 0) {
+      report.firstTime = candleAt(0).timestamp;
+      report.lastTime = candleAt(count - 1).timestamp;
+    }
+    report.seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - started)
+                         .count();
+    return report;
+  }
+
+  static inline const MacdRsiKamaStrategy defaultStrategy{};
+
+  IndicatorEngine::Periods periods;
+  const Strategy *strategy;
+  QuoteIncrement increment;
+};
+
+#endif // BACKTEST_H
@@ -0,0 +1,426 @@
+#ifndef BATCH_INDICATORS_H
+#define BATCH_INDICATORS_H
+
+#include "operations.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define BATCH_INDICATORS_X86 1
+#include <immintrin.h>
+#endif
+
+// Whole-series indicators over contiguous arrays, written into caller-owned
+// buffers of `count` doubles (no allocation). Element i is the value after
+// bar i; bars before an indicator is defined are NaN. EMA, MACD, RSI and KAMA
+// match Operations and the streaming states in indicators.h bit for bit.
+//
+// The recurrences themselves (EMA, Wilder smoothing, KAMA) are inherently
+// serial and stay scalar; the element-wise passes around them (differences,
+// KAMA smoothing constants, MACD histogram, averages and Bollinger bands)
+// run on AVX-512 or AVX2 when the CPU has it, picked at runtime, with a
+// portable scalar fallback. The vector paths use separate multiplies and
+// adds, never fused ones, so every ISA gives the same bits.
+class BatchIndicators {
+public:
+  enum class Isa { Scalar, Avx2, Avx512 };
+
+  static bool supported(Isa isa) {
+#ifdef BATCH_INDICATORS_X86
+    if (isa == Isa::Avx512) {
+      return __builtin_cpu_supports("avx512f");
+    }
+    if (isa == Isa::Avx2) {
+      return __builtin_cpu_supports("avx2");
+    }
+#endif
+    return isa == Isa::Scalar;
+  }
+
+  static Isa bestIsa() {
+    static const Isa best = supported(Isa::Avx512) ? Isa::Avx512
+                            : supported(Isa::Avx2) ? Isa::Avx2
+                                                   : Isa::Scalar;
+    return best;
+  }
+
+  static const char *isaName(Isa isa) {
+    switch (isa) {
+    case Isa::Avx512:
+      return "avx512";
+    case Isa::Avx2:
+      return "avx2";
+    default:
+      return "scalar";
+    }
+  }
+
+  // An unsupported `isa` falls back to the best one available.
+  explicit BatchIndicators(Isa isa = bestIsa())
+      : selected(supported(isa) ? isa : bestIsa()) {
+#ifdef BATCH_INDICATORS_X86
+    if (selected == Isa::Avx512) {
+      kernels = {subtractAvx512, divideAvx512, kamaConstantsAvx512,
+                 bandsAvx512};
+    } else if (selected == Isa::Avx2) {
+      kernels = {subtractAvx2, divideAvx2, kamaConstantsAvx2, bandsAvx2};
+    }
+#endif
+  }
+
+  Isa isa() const { return selected; }
+
+  // Same values as Operations::calculateEMA.
+  void ema(const double *in, size_t count, int period, double *out) const {
+    if (count == 0) {
+      return;
+    }
+    const double multiplier = 2.0 / (period + 1);
+    double ema = in[0];
+    out[0] = ema;
+    for (size_t i = 1; i < count; ++i) {
+      ema = (in[i] - ema) * multiplier + ema;
+      out[i] = ema;
+    }
+  }
+
+  // MACD line, signal line and histogram for every bar; histogram may be
+  // null when only the lines are wanted.
+  void macd(const double *closes, size_t count, int shortPeriod,
+            int longPeriod, int signalPeriod, double *line, double *signal,
+            double *histogram) const {
+    ema(closes, count, shortPeriod, line);
+    ema(closes, count, longPeriod, signal); // long EMA, reused below
+    kernels.subtract(line, signal, line, count);
+    ema(line, count, signalPeriod, signal);
+    if (histogram) {
+      kernels.subtract(line, signal, histogram, count);
+    }
+  }
+
+  // Wilder RSI as in Operations::calculateRSI; defined from index period.
+  void rsi(const double *closes, size_t count, size_t period,
+           double *out) const {
+    if (period == 0 || count < period + 1) {
+      throw std::invalid_argument("Not enough data to calculate RSI.");
+    }
+    // Bar-to-bar changes first, then the smoothing reads them in place.
+    kernels.subtract(closes + 1, closes, out + 1, count - 1);
+
+    double gain = 0.0, loss = 0.0;
+    for (size_t i = 1; i <= period; ++i) {
+      double change = out[i];
+      if (change > 0) {
+        gain += change;
+      } else {
+        loss -= change;
+      }
+      out[i - 1] = std::numeric_limits<double>::quiet_NaN();
+    }
+    gain /= period;
+    loss /= period;
+    out[period] = rsiValue(gain, loss);
+
+    for (size_t i = period + 1; i < count; ++i) {
+      double change = out[i];
+      if (change > 0) {
+        gain = (gain * (period - 1) + change) / period;
+        loss = (loss * (period - 1)) / period;
+      } else {
+        gain = (gain * (period - 1)) / period;
+        loss = (loss * (period - 1) - change) / period;
+      }
+      out[i] = rsiValue(gain, loss);
+    }
+  }
+
+  // KAMA as in Operations::calculateKAMASeries; defined from period - 1.
+  void kama(const double *closes, size_t count, size_t period,
+            double *out) const {
+    if (period == 0 || count < period) {
+      throw std::invalid_argument("Not enough data to calculate KAMA.");
+    }
+
+    // Rolling volatility, stored in out[] until the last pass.
+    double volatility = 0.0;
+    for (size_t i = 1; i < count; ++i) {
+      double change = std::abs(closes[i] - closes[i - 1]);
+      if (i <= period) {
+        volatility += change;
+      } else {
+        volatility +=
+            change - std::abs(closes[i - period] - closes[i - period - 1]);
+      }
+      out[i] = volatility;
+    }
+
+    kernels.kamaConstants(closes, out, period, count);
+
+    for (size_t i = 0; i + 1 < period; ++i) {
+      out[i] = std::numeric_limits<double>::quiet_NaN();
+    }
+    double kama = closes[period - 1];
+    out[period - 1] = kama;
+    for (size_t i = period; i < count; ++i) {
+      kama += out[i] * (closes[i] - kama);
+      out[i] = kama;
+    }
+  }
+
+  // Simple moving average; defined from period - 1.
+  void sma(const double *in, size_t count, size_t period, double *out) const {
+    if (period == 0 || count < period) {
+      throw std::invalid_argument("Not enough data to calculate SMA.");
+    }
+    rollingSum(in, count, period, 0.0, out, nullptr);
+    kernels.divide(out + period - 1, static_cast<double>(period),
+                   out + period - 1, count - period + 1);
+  }
+
+  // Bollinger bands: the period SMA and `width` population standard
+  // deviations either side; defined from period - 1.
+  void bollinger(const double *in, size_t count, size_t period, double width,
+                 double *middle, double *upper, double *lower) const {
+    if (period == 0 || count < period) {
+      throw std::invalid_argument("Not enough data to calculate Bollinger.");
+    }
+    // Sums are taken around the first value so the variance does not cancel
+    // catastrophically at high price levels.
+    const double shift = in[0];
+    rollingSum(in, count, period, shift, middle, upper);
+    const size_t first = period - 1;
+    kernels.bands(middle + first, upper + first, lower + first,
+                  count - first, static_cast<double>(period), shift, width);
+  }
+
+private:
+  struct Kernels {
+    // out[i] = a[i] - b[i]
+    void (*subtract)(const double *a, const double *b, double *out, size_t n);
+    // out[i] = in[i] / divisor
+    void (*divide)(const double *in, double divisor, double *out, size_t n);
+    // out[i] = Operations::kamaSmoothingConstant(|c[i] - c[i - period]|,
+    // out[i]) for i in [period, count)
+    void (*kamaConstants)(const double *closes, double *out, size_t period,
+                          size_t count);
+    // Turns rolling sums (sum in mid, sum of squares in up) of values less
+    // `shift` into the middle, upper and lower band.
+    void (*bands)(double *mid, double *up, double *lo, size_t n,
+                  double period, double shift, double width);
+  };
+
+  static double rsiValue(double gain, double loss) {
+    double rs = (loss == 0.0) ? 100.0 : gain / loss;
+    return 100.0 - (100.0 / (1.0 + rs));
+  }
+
+  // Rolling sum (and optionally sum of squares) of in[i] - shift over the
+  // last `period` values; entries before period - 1 are NaN.
+  static void rollingSum(const double *in, size_t count, size_t period,
+                         double shift, double *sums, double *squares) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    double sum = 0.0, sumSquares = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+      double value = in[i] - shift;
+      sum += value;
+      sumSquares += value * value;
+      if (i >= period) {
+        double old = in[i - period] - shift;
+        sum -= old;
+        sumSquares -= old * old;
+      }
+      sums[i] = i + 1 >= period ? sum : nan;
+      if (squares) {
+        squares[i] = i + 1 >= period ? sumSquares : nan;
+      }
+    }
+  }
+
+  static void subtractScalar(const double *a, const double *b, double *out,
+                             size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      out[i] = a[i] - b[i];
+    }
+  }
+
+  static void divideScalar(const double *in, double divisor, double *out,
+                           size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      out[i] = in[i] / divisor;
+    }
+  }
+
+  static void kamaConstantsScalar(const double *closes, double *out,
+                                  size_t period, size_t count) {
+    kamaConstantsFrom(closes, out, period, period, count);
+  }
+
+  static void kamaConstantsFrom(const double *closes, double *out,
+                                size_t period, size_t first, size_t count) {
+    for (size_t i = first; i < count; ++i) {
+      out[i] = Operations::kamaSmoothingConstant(
+          std::abs(closes[i] - closes[i - period]), out[i]);
+    }
+  }
+
+  static void bandsScalar(double *mid, double *up, double *lo, size_t n,
+                          double period, double shift, double width) {
+    for (size_t i = 0; i < n; ++i) {
+      double mean = mid[i] / period;
+      double variance = std::max(up[i] / period - mean * mean, 0.0);
+      double deviation = std::sqrt(variance) * width;
+      mid[i] = mean + shift;
+      up[i] = mid[i] + deviation;
+      lo[i] = mid[i] - deviation;
+    }
+  }
+
+#ifdef BATCH_INDICATORS_X86
+  // Fastest and slowest smoothing constants of kamaSmoothingConstant.
+  static constexpr double KamaFastest = 2.0 / (2 + 1);
+  static constexpr double KamaSlowest = 2.0 / (30 + 1);
+
+  __attribute__((target("avx2"), optimize("fp-contract=off"))) static void
+  subtractAvx2(const double *a, const double *b, double *out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+      _mm256_storeu_pd(out + i, _mm256_sub_pd(_mm256_loadu_pd(a + i),
+                                              _mm256_loadu_pd(b + i)));
+    }
+    subtractScalar(a + i, b + i, out + i, n - i);
+  }
+
+  __attribute__((target("avx2"), optimize("fp-contract=off"))) static void
+  divideAvx2(const double *in, double divisor, double *out, size_t n) {
+    const __m256d d = _mm256_set1_pd(divisor);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+      _mm256_storeu_pd(out + i, _mm256_div_pd(_mm256_loadu_pd(in + i), d));
+    }
+    divideScalar(in + i, divisor, out + i, n - i);
+  }
+
+  __attribute__((target("avx2"), optimize("fp-contract=off"))) static void
+  kamaConstantsAvx2(const double *closes, double *out, size_t period,
+                    size_t count) {
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d range = _mm256_set1_pd(KamaFastest - KamaSlowest);
+    const __m256d slowest = _mm256_set1_pd(KamaSlowest);
+    size_t i = period;
+    for (; i + 4 <= count; i += 4) {
+      __m256d change = _mm256_andnot_pd(
+          signBit, _mm256_sub_pd(_mm256_loadu_pd(closes + i),
+                                 _mm256_loadu_pd(closes + i - period)));
+      __m256d volatility = _mm256_loadu_pd(out + i);
+      // min(1.0, x) keeps std::min's operand order.
+      __m256d er = _mm256_min_pd(one, _mm256_div_pd(change, volatility));
+      er = _mm256_and_pd(er, _mm256_cmp_pd(volatility, zero, _CMP_GT_OQ));
+      __m256d sc = _mm256_add_pd(_mm256_mul_pd(er, range), slowest);
+      _mm256_storeu_pd(out + i, _mm256_mul_pd(sc, sc));
+    }
+    kamaConstantsFrom(closes, out, period, i, count);
+  }
+
+  __attribute__((target("avx2"), optimize("fp-contract=off"))) static void
+  bandsAvx2(double *mid, double *up, double *lo, size_t n, double period,
+            double shift, double width) {
+    const __m256d p = _mm256_set1_pd(period);
+    const __m256d s = _mm256_set1_pd(shift);
+    const __m256d w = _mm256_set1_pd(width);
+    const __m256d zero = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+      __m256d mean = _mm256_div_pd(_mm256_loadu_pd(mid + i), p);
+      __m256d variance =
+          _mm256_sub_pd(_mm256_div_pd(_mm256_loadu_pd(up + i), p),
+                        _mm256_mul_pd(mean, mean));
+      variance = _mm256_max_pd(variance, zero);
+      __m256d deviation = _mm256_mul_pd(_mm256_sqrt_pd(variance), w);
+      __m256d middle = _mm256_add_pd(mean, s);
+      _mm256_storeu_pd(mid + i, middle);
+      _mm256_storeu_pd(up + i, _mm256_add_pd(middle, deviation));
+      _mm256_storeu_pd(lo + i, _mm256_sub_pd(middle, deviation));
+    }
+    bandsScalar(mid + i, up + i, lo + i, n - i, period, shift, width);
+  }
+
+  __attribute__((target("avx512f"), optimize("fp-contract=off"))) static void
+  subtractAvx512(const double *a, const double *b, double *out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      _mm512_storeu_pd(out + i, _mm512_sub_pd(_mm512_loadu_pd(a + i),
+                                              _mm512_loadu_pd(b + i)));
+    }
+    subtractScalar(a + i, b + i, out + i, n - i);
+  }
+
+  __attribute__((target("avx512f"), optimize("fp-contract=off"))) static void
+  divideAvx512(const double *in, double divisor, double *out, size_t n) {
+    const __m512d d = _mm512_set1_pd(divisor);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      _mm512_storeu_pd(out + i, _mm512_div_pd(_mm512_loadu_pd(in + i), d));
+    }
+    divideScalar(in + i, divisor, out + i, n - i);
+  }
+
+  __attribute__((target("avx512f"), optimize("fp-contract=off"))) static void
+  kamaConstantsAvx512(const double *closes, double *out, size_t period,
+                      size_t count) {
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d range = _mm512_set1_pd(KamaFastest - KamaSlowest);
+    const __m512d slowest = _mm512_set1_pd(KamaSlowest);
+    size_t i = period;
+    for (; i + 8 <= count; i += 8) {
+      __m512d change = _mm512_abs_pd(
+          _mm512_sub_pd(_mm512_loadu_pd(closes + i),
+                        _mm512_loadu_pd(closes + i - period)));
+      __m512d volatility = _mm512_loadu_pd(out + i);
+      __mmask8 positive = _mm512_cmp_pd_mask(volatility, _mm512_setzero_pd(),
+                                             _CMP_GT_OQ);
+      __m512d er = _mm512_maskz_div_pd(positive, change, volatility);
+      er = _mm512_maskz_min_pd(positive, one, er);
+      __m512d sc = _mm512_add_pd(_mm512_mul_pd(er, range), slowest);
+      _mm512_storeu_pd(out + i, _mm512_mul_pd(sc, sc));
+    }
+    kamaConstantsFrom(closes, out, period, i, count);
+  }
+
+  __attribute__((target("avx512f"), optimize("fp-contract=off"))) static void
+  bandsAvx512(double *mid, double *up, double *lo, size_t n, double period,
+              double shift, double width) {
+    const __m512d p = _mm512_set1_pd(period);
+    const __m512d s = _mm512_set1_pd(shift);
+    const __m512d w = _mm512_set1_pd(width);
+    const __m512d zero = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      __m512d mean = _mm512_div_pd(_mm512_loadu_pd(mid + i), p);
+      __m512d variance =
+          _mm512_sub_pd(_mm512_div_pd(_mm512_loadu_pd(up + i), p),
+                        _mm512_mul_pd(mean, mean));
+      // The zero-masked forms with a full mask are the plain instructions;
+      // they avoid a spurious -Wmaybe-uninitialized in GCC 12's headers.
+      variance = _mm512_maskz_max_pd(0xff, variance, zero);
+      __m512d deviation =
+          _mm512_mul_pd(_mm512_maskz_sqrt_pd(0xff, variance), w);
+      __m512d middle = _mm512_add_pd(mean, s);
+      _mm512_storeu_pd(mid + i, middle);
+      _mm512_storeu_pd(up + i, _mm512_add_pd(middle, deviation));
+      _mm512_storeu_pd(lo + i, _mm512_sub_pd(middle, deviation));
+    }
+    bandsScalar(mid + i, up + i, lo + i, n - i, period, shift, width);
+  }
+#endif
+
+  Isa selected;
+  Kernels kernels{subtractScalar, divideScalar, kamaConstantsScalar,
+                  bandsScalar};
+};
+
+#endif // BATCH_INDICATORS_H
@@ -0,0 +1,897 @@
+// Micro-benchmarks for the hot paths. Build with build.sh and run
+//
+//   ./bench [--candles response.json | --synthetic] [suite...]
+//
+// Suites: parse fetch fetchMany operations batch pipeline history feed
+// (default: all).
+// The /candles body comes from fixtures/candles-btc-usd-60.json, a 300-row
+// response in the API's format; --candles replays another one, e.g. saved
+// with
+//   curl -o response.json 'https://api.exchange.coinbase.com/products/
+//   BTC-USD/candles?granularity=60'
+// and --synthetic uses a built-in generated body. The default fixture is
+// looked up next to this source, next to the binary, then under the working
+// directory; if it is in none of them bench exits non-zero. The local HTTP
+// stand-in serves whichever body is in use. Latency suites time every call
+// on its own and report p50/p99 with allocations per operation.
+// Building with -DBENCH_JSONCPP -ljsoncpp adds the old jsoncpp DOM parse to
+// the parse suite as a baseline.
+
+#include "batch_indicators.h"
+#include "candle_aggregator.h"
+#include "candle_parser.h"
+#include "candle_series.h"
+#include "coinbase.h"
+#include "coinbase_feed.h"
+#include "operations.h"
+#include "price_scale.h"
+#include "result_history.h"
+#include "strategy.h"
+#include "timestamp_format.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <memory>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <new>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#ifdef BENCH_JSONCPP
+#include <json/json.h>
+#include <sstream>
+#endif
+
+// Global allocation counter so each benchmark can report allocations per op.
+static std::atomic<size_t> allocationCount{0};
+
+void *operator new(size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+// Out of line, so GCC does not see a malloc/free pair inlined into callers
+// and warn about mismatched new/delete.
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+  std::free(p);
+}
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept {
+  std::free(p);
+}
+
+// Deterministic stand-in for a 300-bucket /candles response, newest first.
+static std::string makeCandlesResponse(size_t rows) {
+  std::string body = "[";
+  double price = 97000.0;
+  long long time = 1735689600 + static_cast<long long>(rows) * 60;
+  char row[160];
+  for (size_t i = 0; i < rows; ++i) {
+    price += ((i * 7919) % 200) / 10.0 - 10.0;
+    int n = std::snprintf(row, sizeof(row),
+                          "%s[%lld,%.2f,%.2f,%.2f,%.2f,%.8f]", i ? "," : "",
+                          time, price - 12.5, price + 14.25, price - 3.1,
+                          price, 1.5 + (i % 13) * 0.37);
+    body.append(row, n);
+    time -= 60;
+  }
+  body += "]";
+  return body;
+}
+
+// Loopback HTTP/1.1 server that answers every request with the same body and
+// keeps connections alive, standing in for api.exchange.coinbase.com. An
+// optional delay simulates the exchange's round trip.
+class LocalHttpServer {
+public:
+  explicit LocalHttpServer(
+      std::string responseBody,
+      std::chrono::milliseconds delay = std::chrono::milliseconds(0))
+      : body(std::move(responseBody)), delay(delay) {
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+    listen(listenFd, 64);
+    socklen_t len = sizeof(addr);
+    getsockname(listenFd, reinterpret_cast<sockaddr *>(&addr), &len);
+    boundPort = ntohs(addr.sin_port);
+    acceptThread = std::thread(&LocalHttpServer::acceptLoop, this);
+  }
+
+  ~LocalHttpServer() {
+    shutdown(listenFd, SHUT_RDWR);
+    close(listenFd);
+    acceptThread.join();
+    std::lock_guard<std::mutex> lock(connectionsMutex);
+    for (int fd : connectionFds) {
+      shutdown(fd, SHUT_RDWR);
+    }
+    for (auto &t : connectionThreads) {
+      t.join();
+    }
+  }
+
+  std::string url() const {
+    return "http://127.0.0.1:" + std::to_string(boundPort);
+  }
+  size_t acceptedConnections() const { return accepted.load(); }
+
+private:
+  void acceptLoop() {
+    for (;;) {
+      int fd = accept(listenFd, nullptr, nullptr);
+      if (fd < 0) {
+        return;
+      }
+      accepted++;
+      std::lock_guard<std::mutex> lock(connectionsMutex);
+      connectionFds.push_back(fd);
+      connectionThreads.emplace_back(&LocalHttpServer::serve, this, fd);
+    }
+  }
+
+  void serve(int fd) {
+    // One send per response so Nagle never holds back the body.
+    const std::string response = "HTTP/1.1 200 OK\r\n"
+                                 "Content-Type: application/json\r\n"
+                                 "Connection: keep-alive\r\n"
+                                 "Content-Length: " +
+                                 std::to_string(body.size()) + "\r\n\r\n" +
+                                 body;
+    std::string request;
+    char buffer[4096];
+    for (;;) {
+      ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+      if (n <= 0) {
+        break;
+      }
+      request.append(buffer, n);
+      size_t end;
+      while ((end = request.find("\r\n\r\n")) != std::string::npos) {
+        request.erase(0, end + 4);
+        if (delay.count() > 0) {
+          std::this_thread::sleep_for(delay);
+        }
+        send(fd, response.data(), response.size(), MSG_NOSIGNAL);
+      }
+    }
+    close(fd);
+  }
+
+  std::string body;
+  std::chrono::milliseconds delay;
+  int listenFd = -1;
+  int boundPort = 0;
+  std::atomic<size_t> accepted{0};
+  std::thread acceptThread;
+  std::mutex connectionsMutex;
+  std::vector<int> connectionFds;
+  std::vector<std::thread> connectionThreads;
+};
+
+// Coinbase `match` messages for a deterministic walk, one trade every 200 ms.
+// trade_id is the message's index, so the receiver can find its send time.
+static std::vector<std::string> makeMatchMessages(size_t count) {
+  std::vector<std::string> messages;
+  messages.reserve(count);
+  double price = 97000.0;
+  const long long start = 1735689600LL * 1000000;
+  char time[40];
+  char message[400];
+  for (size_t i = 0; i < count; ++i) {
+    price += ((i * 7919) % 200) / 10.0 - 9.95;
+    long long micros = start + static_cast<long long>(i) * 200000;
+    std::time_t seconds = static_cast<std::time_t>(micros / 1000000);
+    std::tm tm;
+    gmtime_r(&seconds, &tm);
+    size_t n = std::strftime(time, sizeof(time), "%Y-%m-%dT%H:%M:%S", &tm);
+    std::snprintf(time + n, sizeof(time) - n, ".%06lldZ", micros % 1000000);
+    int len = std::snprintf(
+        message, sizeof(message),
+        "{\"type\":\"match\",\"trade_id\":%zu,\"maker_order_id\":"
+        "\"ac928c66-ca53-498f-9c13-a110027a60e8\",\"taker_order_id\":"
+        "\"132fb6ae-456b-4654-b4e0-d681ac05cea1\",\"side\":\"%s\",\"size\":"
+        "\"%.8f\",\"price\":\"%.2f\",\"product_id\":\"BTC-USD\","
+        "\"sequence\":%zu,\"time\":\"%s\"}",
+        i, i % 3 ? "buy" : "sell", 0.001 + (i % 17) * 0.0137, price,
+        50000000 + i, time);
+    messages.emplace_back(message, len);
+  }
+  return messages;
+}
+
+// Loopback WebSocket server standing in for ws-feed.exchange.coinbase.com.
+// Accepts one client, waits for its subscribe message, then replays the
+// given messages as text frames, `spacing` apart, noting when each was sent.
+class LocalWsServer {
+public:
+  LocalWsServer(std::vector<std::string> replay,
+                std::chrono::microseconds spacing)
+      : messages(std::move(replay)), spacing(spacing),
+        sentAt(new std::atomic<long long>[messages.size()]) {
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+    listen(listenFd, 1);
+    socklen_t len = sizeof(addr);
+    getsockname(listenFd, reinterpret_cast<sockaddr *>(&addr), &len);
+    boundPort = ntohs(addr.sin_port);
+    thread = std::thread(&LocalWsServer::serve, this);
+  }
+
+  ~LocalWsServer() {
+    shutdown(listenFd, SHUT_RDWR);
+    close(listenFd);
+    thread.join();
+  }
+
+  std::string url() const {
+    return "ws://127.0.0.1:" + std::to_string(boundPort);
+  }
+
+  // steady_clock nanoseconds at which message i left the server.
+  long long sentTime(size_t i) const { return sentAt[i].load(); }
+
+private:
+  void serve() {
+    int fd = accept(listenFd, nullptr, nullptr);
+    if (fd < 0) {
+      return;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (handshake(fd) && awaitFrame(fd)) {
+      for (size_t i = 0; i < messages.size(); ++i) {
+        std::this_thread::sleep_for(spacing);
+        sentAt[i].store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now().time_since_epoch())
+                            .count());
+        sendFrame(fd, 0x81, messages[i]);
+      }
+      sendFrame(fd, 0x88, std::string()); // close
+      char buffer[256];
+      while (recv(fd, buffer, sizeof(buffer), 0) > 0) {
+      }
+    }
+    close(fd);
+  }
+
+  bool handshake(int fd) {
+    std::string request;
+    char buffer[4096];
+    while (request.find("\r\n\r\n") == std::string::npos) {
+      ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+      if (n <= 0) {
+        return false;
+      }
+      request.append(buffer, n);
+    }
+    const std::string header = "Sec-WebSocket-Key: ";
+    size_t at = request.find(header);
+    if (at == std::string::npos) {
+      return false;
+    }
+    at += header.size();
+    const std::string key =
+        request.substr(at, request.find("\r\n", at) - at);
+
+    std::string response = "HTTP/1.1 101 Switching Protocols\r\n"
+                           "Upgrade: websocket\r\n"
+                           "Connection: Upgrade\r\n"
+                           "Sec-WebSocket-Accept: ";
+    response += CoinbaseFeed::acceptFor(key);
+    response += "\r\n\r\n";
+    return send(fd, response.data(), response.size(), MSG_NOSIGNAL) > 0;
+  }
+
+  // Reads one (masked) client frame, the subscribe request.
+  static bool awaitFrame(int fd) {
+    unsigned char header[14];
+    if (recv(fd, header, 2, MSG_WAITALL) != 2) {
+      return false;
+    }
+    size_t length = header[1] & 0x7f;
+    size_t extra = length == 126 ? 2 : length == 127 ? 8 : 0;
+    if (extra && recv(fd, header + 2, extra, MSG_WAITALL) !=
+                     static_cast<ssize_t>(extra)) {
+      return false;
+    }
+    if (length >= 126) {
+      length = 0;
+      for (size_t i = 0; i < extra; ++i) {
+        length = length << 8 | header[2 + i];
+      }
+    }
+    std::string payload(length + 4, '\0'); // mask key + payload
+    return recv(fd, &payload[0], payload.size(), MSG_WAITALL) ==
+           static_cast<ssize_t>(payload.size());
+  }
+
+  static void sendFrame(int fd, unsigned char opcode,
+                        const std::string &payload) {
+    std::string frame(1, static_cast<char>(opcode));
+    if (payload.size() < 126) {
+      frame += static_cast<char>(payload.size());
+    } else {
+      frame += static_cast<char>(126);
+      frame += static_cast<char>(payload.size() >> 8);
+      frame += static_cast<char>(payload.size() & 0xff);
+    }
+    frame += payload;
+    send(fd, frame.data(), frame.size(), MSG_NOSIGNAL);
+  }
+
+  std::vector<std::string> messages;
+  std::chrono::microseconds spacing;
+  std::unique_ptr<std::atomic<long long>[]> sentAt;
+  int listenFd = -1;
+  int boundPort = 0;
+  std::thread thread;
+};
+
+static double percentile(std::vector<double> values, double p) {
+  if (values.empty()) {
+    return 0.0;
+  }
+  std::sort(values.begin(), values.end());
+  size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+  return values[index];
+}
+
+struct BenchResult {
+  double nsPerOp;
+  double allocsPerOp;
+};
+
+template <typename Fn> static BenchResult run(size_t iterations, Fn fn) {
+  fn(); // warm-up
+  size_t allocsBefore = allocationCount.load();
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    fn();
+  }
+  auto end = std::chrono::steady_clock::now();
+  size_t allocs = allocationCount.load() - allocsBefore;
+  double ns = std::chrono::duration<double, std::nano>(end - begin).count();
+  return {ns / iterations, static_cast<double>(allocs) / iterations};
+}
+
+static void report(const char *name, const BenchResult &r, size_t bytes) {
+  double mbPerSec = bytes / r.nsPerOp * 1e3; // bytes/ns -> MB/s
+  std::printf("%-28s %10.0f ns/op %10.1f MB/s %10.1f allocs/op\n", name,
+              r.nsPerOp, mbPerSec, r.allocsPerOp);
+}
+
+struct Latency {
+  double p50Ns;
+  double p99Ns;
+  double allocsPerOp;
+};
+
+// Times each call separately so the tail shows up, not just the mean. The
+// clock read adds a few tens of ns to every sample.
+template <typename Fn> static Latency measure(size_t iterations, Fn fn) {
+  fn(); // warm-up
+  std::vector<double> samples(iterations);
+  size_t allocsBefore = allocationCount.load();
+  for (size_t i = 0; i < iterations; ++i) {
+    auto begin = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    samples[i] = std::chrono::duration<double, std::nano>(end - begin).count();
+  }
+  size_t allocs = allocationCount.load() - allocsBefore;
+  return {percentile(samples, 0.50), percentile(samples, 0.99),
+          static_cast<double>(allocs) / iterations};
+}
+
+static void report(const char *name, const Latency &l) {
+  std::printf("%-28s p50 %10.0f ns  p99 %10.0f ns %8.1f allocs/op\n", name,
+              l.p50Ns, l.p99Ns, l.allocsPerOp);
+}
+
+static const char *const DefaultFixture = "fixtures/candles-btc-usd-60.json";
+
+// Directory part of `path` with its trailing '/', or "" for a bare name.
+static std::string directoryOf(const char *path) {
+  const char *slash = std::strrchr(path, '/');
+  return slash ? std::string(path, slash + 1) : std::string();
+}
+
+// The default fixture next to this source file, next to the binary (build.sh
+// puts it in the source tree) or under the working directory, whichever
+// exists first; "" when none does.
+static std::string findDefaultFixture(const char *argv0) {
+  const std::string candidates[] = {directoryOf(__FILE__) + DefaultFixture,
+                                    directoryOf(argv0) + DefaultFixture,
+                                    DefaultFixture};
+  for (const std::string &path : candidates) {
+    if (std::ifstream(path, std::ios::binary)) {
+      return path;
+    }
+  }
+  return {};
+}
+
+// Body of a saved /candles response; exits when it cannot be read.
+static std::string loadFixture(const char *path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    std::fprintf(stderr, "bench: cannot read %s\n", path);
+    std::exit(1);
+  }
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+static void benchParse(const std::string &body) {
+  const size_t iterations = 2000;
+  volatile double sink = 0.0;
+
+#ifdef BENCH_JSONCPP
+  // The previous fetch path: copy into an istringstream and build a DOM.
+  BenchResult dom = run(iterations, [&] {
+    Json::Value jsonData;
+    Json::CharReaderBuilder builder;
+    std::istringstream stream(body);
+    std::string errs;
+    CandleSeries series;
+    if (Json::parseFromStream(builder, stream, &jsonData, &errs)) {
+      for (const auto &candle : jsonData) {
+        series.append(static_cast<std::time_t>(candle[0].asInt64()),
+                      candle[3].asDouble(), candle[2].asDouble(),
+                      candle[1].asDouble(), candle[4].asDouble(),
+                      candle[5].asDouble());
+      }
+    }
+    sink = sink + series.close().back();
+  });
+#endif
+
+  // The streaming parser, fed in 16 KiB chunks like curl delivers them.
+  CandleSeries series;
+  BenchResult streaming = run(iterations, [&] {
+    series.clear();
+    CandleParser parser(series);
+    for (size_t off = 0; off < body.size(); off += 16384) {
+      size_t n = body.size() - off < 16384 ? body.size() - off : 16384;
+      parser.feed(body.data() + off, n);
+    }
+    parser.finish();
+    sink = sink + series.close().back();
+  });
+
+  std::printf("parse: %zu candles, %zu bytes\n", series.size(), body.size());
+#ifdef BENCH_JSONCPP
+  report("  jsoncpp DOM", dom, body.size());
+#endif
+  report("  CandleParser", streaming, body.size());
+}
+
+// Steady-state polling against the local stand-in: one client, many
+// requests. A warm client should open a single connection and reuse it.
+static void benchFetch(const std::string &body) {
+  LocalHttpServer server(body);
+  const size_t requests = 200;
+  std::vector<double> latencies;
+  latencies.reserve(requests);
+  size_t failures = 0;
+
+  Coinbase coinbase(server.url());
+  CandleSeries series;
+  series.reserve(300);
+  for (size_t i = 0; i < requests; ++i) {
+    series.clear();
+    if (!coinbase.fetchCoinbaseData("BTC-USD", 60, 0, 0, series)) {
+      failures++;
+    }
+    latencies.push_back(coinbase.requestStats().lastLatencyMs);
+  }
+
+  const Coinbase::RequestStats &stats = coinbase.requestStats();
+  std::printf("fetch: %zu requests against %s\n", requests,
+              server.url().c_str());
+  std::printf("  connections opened %zu (server accepted %zu), failures %zu\n",
+              stats.connectionsOpened, server.acceptedConnections(), failures);
+  std::printf("  latency p50 %.3f ms  p99 %.3f ms  mean %.3f ms\n",
+              percentile(latencies, 0.50), percentile(latencies, 0.99),
+              stats.totalLatencyMs / stats.requests);
+}
+
+// Many products with a simulated 20 ms exchange round trip: serial polling
+// versus one curl_multi batch.
+static void benchFetchMany(const std::string &body) {
+  LocalHttpServer server(body, std::chrono::milliseconds(20));
+  std::vector<Coinbase::FetchRequest> requests;
+  const char *products[] = {"BTC-USD", "ETH-USD", "SOL-USD", "ADA-USD",
+                            "XRP-USD", "DOGE-USD", "LTC-USD", "DOT-USD",
+                            "AVAX-USD", "LINK-USD", "BCH-USD", "XLM-USD",
+                            "UNI-USD", "ATOM-USD", "ETC-USD", "FIL-USD"};
+  for (const char *product : products) {
+    requests.push_back({product, 60, 0, 0});
+  }
+
+  Coinbase serialClient(server.url());
+  CandleSeries series;
+  auto serialBegin = std::chrono::steady_clock::now();
+  for (const auto &request : requests) {
+    series.clear();
+    serialClient.fetchCoinbaseData(request.productId, request.granularity, 0,
+                                   0, series);
+  }
+  double serialMs = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - serialBegin)
+                        .count();
+
+  Coinbase multiClient(server.url());
+  std::vector<double> latencies;
+  size_t failures = 0;
+  auto multiBegin = std::chrono::steady_clock::now();
+  multiClient.fetchMany(requests, 8,
+                        [&](const Coinbase::FetchResult &result) {
+                          latencies.push_back(result.latencyMs);
+                          failures += result.ok ? 0 : 1;
+                        });
+  double multiMs = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - multiBegin)
+                       .count();
+
+  std::printf("fetchMany: %zu products, 20 ms simulated round trip\n",
+              requests.size());
+  std::printf("  serial %.1f ms, multi (8 in flight) %.1f ms, failures %zu\n",
+              serialMs, multiMs, failures);
+  std::printf("  per-request p50 %.3f ms  p99 %.3f ms\n",
+              percentile(latencies, 0.50), percentile(latencies, 0.99));
+}
+
+// A month of one-minute results through a one-day ResultHistory: pushes
+// once the ring is full (each spills one record), then reads spread across
+// the spilled segments and the ring.
+static void benchHistory() {
+  const size_t month = 30 * 24 * 60;
+  const std::string dir = "/tmp/bench-results-" + std::to_string(getpid());
+  ResultHistory history(24 * 60, dir);
+  Result res{};
+  res.normalized_timestamp = 60;
+  for (size_t i = 0; i < history.capacity(); ++i) {
+    res.timestamp = static_cast<time_t>(i * 60);
+    history.push(res);
+  }
+
+  size_t allocsBefore = allocationCount.load();
+  Latency push = measure(month - history.capacity() - 1, [&] {
+    res.timestamp += 60;
+    res.price += 0.5;
+    history.push(res);
+  });
+  size_t allocs = allocationCount.load() - allocsBefore;
+
+  volatile double sink = 0.0;
+  size_t next = 0;
+  Latency read = measure(100000, [&] {
+    next = (next + 7919) % history.size();
+    sink = sink + history[next].price;
+  });
+
+  std::printf("history: %zu results, %zu in memory, %zu spilled\n",
+              history.size(), history.capacity(), history.spilledCount());
+  report("  push", push);
+  report("  read (any index)", read);
+  std::printf("  %zu allocations over the month (segment bookkeeping)\n",
+              allocs);
+  std::filesystem::remove_all(dir);
+}
+
+// WebSocket trades through aggregation and a tick-by-tick strategy preview,
+// timed from the stand-in's send to the signal being available.
+static void benchFeed() {
+  const size_t count = 3000;
+  const int granularity = 5; // sub-minute candles, 25 trades each
+  std::vector<std::string> messages = makeMatchMessages(count);
+
+  volatile double sink = 0.0;
+  CoinbaseFeed::Trade parsed{};
+  size_t next = 0;
+  BenchResult parse = run(10000, [&] {
+    const std::string &m = messages[next++ % messages.size()];
+    CoinbaseFeed::parseTrade(m.data(), m.size(), parsed);
+    sink = sink + parsed.price;
+  });
+
+  LocalWsServer server(messages, std::chrono::microseconds(100));
+  CoinbaseFeed feed(server.url());
+  if (!feed.connect() || !feed.subscribe({"BTC-USD"})) {
+    std::printf("feed: could not connect to %s\n", server.url().c_str());
+    return;
+  }
+
+  CandleAggregator aggregator(granularity);
+  StrategyEngine engine;
+  engine.add(std::make_unique<MacdRsiKamaStrategy>());
+  std::vector<double> latencies;
+  latencies.reserve(count);
+  size_t closedCandles = 0;
+  size_t trades = 0;
+  size_t actionable = 0;
+  size_t allocsBefore = allocationCount.load();
+
+  while (trades < count &&
+         feed.poll(1000, [&](const CoinbaseFeed::Trade &trade) {
+           Candle closed;
+           if (aggregator.add(trade.timeMicros, trade.price, trade.size,
+                              closed)) {
+             engine.update(closed);
+             ++closedCandles;
+           }
+           Signal signal = engine.preview(aggregator.current())[0];
+           actionable += signal != Signal::Hold;
+           long long now =
+               std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+                   .count();
+           latencies.push_back((now - server.sentTime(trade.tradeId)) / 1e3);
+           ++trades;
+         })) {
+  }
+  size_t allocs = allocationCount.load() - allocsBefore;
+
+  std::printf("feed: %zu match messages over %s, %d s candles\n", count,
+              server.url().c_str(), granularity);
+  report("  parseTrade", parse, messages[0].size());
+  std::printf("  trades %zu, candles closed %zu, non-HOLD previews %zu\n",
+              trades, closedCandles, actionable);
+  std::printf("  tick-to-signal p50 %.1f us  p99 %.1f us, %.2f allocs/tick\n",
+              percentile(latencies, 0.50), percentile(latencies, 0.99),
+              trades ? static_cast<double>(allocs) / trades : 0.0);
+}
+
+// Every Operations function over the response's candles, as the render
+// and fetch paths call them.
+static void benchOperations(const std::string &body) {
+  CandleSeries series;
+  CandleParser parser(series);
+  parser.feed(body.data(), body.size());
+  if (!parser.finish() || series.size() < 30) {
+    std::printf("operations: response has too few candles\n");
+    return;
+  }
+  const std::vector<Coinbase::Candle> candles = series.toCandles();
+  const std::vector<double> closes(series.close().begin(),
+                                   series.close().end());
+  std::vector<double> kamaOut(closes.size());
+  const size_t iterations = 2000;
+  Operations operations;
+  volatile double sink = 0.0;
+
+  std::vector<Result> results(1440);
+  for (size_t i = 0; i < results.size(); ++i) {
+    results[i] = {};
+    results[i].timestamp = candles[i % candles.size()].timestamp;
+    results[i].price = closes[i % closes.size()];
+  }
+  const Result &last = results.back();
+  char line[512];
+
+  std::printf("operations: %zu candles\n", candles.size());
+  report("  calculateKAMA (vector)", measure(iterations, [&] {
+           sink = sink + operations.calculateKAMA(candles);
+         }));
+  report("  calculateKAMA (series)", measure(iterations, [&] {
+           sink = sink + operations.calculateKAMA(series);
+         }));
+  report("  calculateKAMASeries", measure(iterations, [&] {
+           operations.calculateKAMASeries(closes.data(), closes.size(), 10,
+                                          kamaOut.data());
+           sink = sink + kamaOut.back();
+         }));
+  report("  calculateRSI (vector)", measure(iterations, [&] {
+           sink = sink + operations.calculateRSI(candles);
+         }));
+  report("  calculateRSI (series)", measure(iterations, [&] {
+           sink = sink + operations.calculateRSI(series);
+         }));
+  report("  calculateEMA", measure(iterations, [&] {
+           sink = sink + operations.calculateEMA(closes, 12).back();
+         }));
+  report("  calculateMACD (vector)", measure(iterations, [&] {
+           sink = sink + operations.calculateMACD(candles).histogram;
+         }));
+  report("  calculateMACD (series)", measure(iterations, [&] {
+           sink = sink + operations.calculateMACD(series).histogram;
+         }));
+  report("  normalizeData (1440)", measure(iterations, [&] {
+           operations.normalizeData(results);
+           sink = sink + results.back().normalized_price;
+         }));
+  PriceScale scale;
+  SlidingMinMax window(240);
+  size_t pushed = 0;
+  report("  PriceScale::push", measure(iterations, [&] {
+           scale.push(closes[pushed++ % closes.size()]);
+           sink = sink + scale.max();
+         }));
+  report("  SlidingMinMax::push (240)", measure(iterations, [&] {
+           window.push(closes[pushed++ % closes.size()]);
+           sink = sink + window.max();
+         }));
+  report("  resultToString", measure(iterations, [&] {
+           sink = sink + operations.resultToString(last).size();
+         }));
+  report("  formatResult", measure(iterations, [&] {
+           sink = sink + Operations::formatResult(last, line, sizeof(line));
+         }));
+  report("  convertToTimestamp", measure(iterations, [&] {
+           sink = sink + operations.convertToTimestamp(last.timestamp).size();
+         }));
+  std::time_t stamp = last.timestamp;
+  report("  TimestampFormat::format", measure(iterations, [&] {
+           sink = sink + TimestampFormat::format(stamp++, line, sizeof(line));
+         }));
+}
+
+// Full-series indicators over a million bars with each instruction set the
+// CPU supports.
+static void benchBatch() {
+  const size_t bars = 1000000;
+  std::vector<double> closes(bars);
+  double price = 97000.0;
+  for (size_t i = 0; i < bars; ++i) {
+    price += ((i * 7919) % 200) / 10.0 - 9.95;
+    closes[i] = price;
+  }
+  std::vector<double> a(bars), b(bars), c(bars);
+  const double *in = closes.data();
+  const size_t iterations = 10;
+
+  std::printf("batch: %zu bars, best ISA %s\n", bars,
+              BatchIndicators::isaName(BatchIndicators::bestIsa()));
+  for (BatchIndicators::Isa isa :
+       {BatchIndicators::Isa::Scalar, BatchIndicators::Isa::Avx2,
+        BatchIndicators::Isa::Avx512}) {
+    if (!BatchIndicators::supported(isa)) {
+      continue;
+    }
+    BatchIndicators batch(isa);
+    auto line = [&](const char *name, const BenchResult &r) {
+      std::printf("  %-8s %-10s %10.1f Mbar/s %10.1f allocs/op\n",
+                  BatchIndicators::isaName(isa), name, bars / r.nsPerOp * 1e3,
+                  r.allocsPerOp);
+    };
+    line("ema", run(iterations, [&] { batch.ema(in, bars, 12, a.data()); }));
+    line("macd", run(iterations, [&] {
+           batch.macd(in, bars, 12, 26, 9, a.data(), b.data(), c.data());
+         }));
+    line("rsi", run(iterations, [&] { batch.rsi(in, bars, 14, a.data()); }));
+    line("kama", run(iterations, [&] { batch.kama(in, bars, 10, a.data()); }));
+    line("sma", run(iterations, [&] { batch.sma(in, bars, 20, a.data()); }));
+    line("bollinger", run(iterations, [&] {
+           batch.bollinger(in, bars, 20, 2.0, a.data(), b.data(), c.data());
+         }));
+  }
+}
+
+// One live candle end to end, as the fetch worker and render loop handle it:
+// fetch and parse from the stand-in, update the strategy engine, build the
+// result, update the chart's price scale and format the analysis line.
+static void benchPipeline(const std::string &body) {
+  LocalHttpServer server(body);
+  Coinbase coinbase(server.url());
+  StrategyEngine strategies;
+  strategies.add(std::make_unique<MacdRsiKamaStrategy>());
+
+  CandleSeries series;
+  if (!coinbase.fetchCoinbaseData("BTC-USD", 60, 0, 0, series) ||
+      series.empty()) {
+    std::printf("pipeline: could not fetch from %s\n", server.url().c_str());
+    return;
+  }
+  for (size_t i = 0; i < series.size(); ++i) {
+    strategies.update(series.at(i));
+  }
+  std::vector<Result> results(1440, strategies.result(series.at(0)));
+  size_t next = 0;
+  PriceScale scale;
+  char line[512];
+  size_t failures = 0;
+  volatile size_t sink = 0;
+
+  Latency latency = measure(500, [&] {
+    series.clear();
+    if (!coinbase.fetchCoinbaseData("BTC-USD", 60, 0, 0, series)) {
+      failures++;
+      return;
+    }
+    const Candle candle = series.at(series.size() - 1);
+    strategies.update(candle);
+    Result &res = results[next++ % results.size()];
+    res = strategies.result(candle);
+    scale.push(res.price);
+    sink = sink + Operations::formatResult(res, line, sizeof(line));
+  });
+
+  std::printf("pipeline: fetch -> signal -> line per candle via %s\n",
+              server.url().c_str());
+  report("  per candle", latency);
+  std::printf("  failures %zu\n", failures);
+}
+
+int main(int argc, char **argv) {
+  std::string body;
+  bool synthetic = false;
+  std::vector<std::string> suites;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--candles") == 0 && i + 1 < argc) {
+      body = loadFixture(argv[++i]);
+    } else if (std::strcmp(argv[i], "--synthetic") == 0) {
+      synthetic = true;
+    } else {
+      suites.push_back(argv[i]);
+    }
+  }
+  if (synthetic) {
+    body = makeCandlesResponse(300);
+  } else if (body.empty()) {
+    // Quietly benchmarking a generated body instead would misreport what
+    // was measured, so a missing fixture is an error.
+    const std::string path = findDefaultFixture(argv[0]);
+    if (path.empty()) {
+      std::fprintf(stderr,
+                   "bench: %s not found; pass --candles <file> or "
+                   "--synthetic\n",
+                   DefaultFixture);
+      return 1;
+    }
+    body = loadFixture(path.c_str());
+  }
+  auto selected = [&suites](const char *name) {
+    return suites.empty() ||
+           std::find(suites.begin(), suites.end(), name) != suites.end();
+  };
+
+  if (selected("parse")) {
+    benchParse(body);
+  }
+  if (selected("fetch")) {
+    benchFetch(body);
+  }
+  if (selected("fetchMany")) {
+    benchFetchMany(body);
+  }
+  if (selected("operations")) {
+    benchOperations(body);
+  }
+  if (selected("batch")) {
+    benchBatch();
+  }
+  if (selected("pipeline")) {
+    benchPipeline(body);
+  }
+  if (selected("history")) {
+    benchHistory();
+  }
+  if (selected("feed")) {
+    benchFeed();
+  }
+  return 0;
+}
@@ -1,4 +1,7 @@
 #!/bin/sh
 
-g++ -o trading_analysis_gui main.cpp -std=c++17 -L/usr/local/lib -lraylib -lcurl  -ljsoncpp -Wall -Wextra -g 
-
+g++ -o trading_analysis_gui main.cpp -std=c++17 -L/usr/local/lib -lraylib -lcurl -Wall -Wextra -O2 -g 
+g++ -o bench bench.cpp -std=c++17 -lcurl -pthread -Wall -Wextra -O2 -g
+g++ -o backtest backtest.cpp -std=c++17 -lcurl -pthread -Wall -Wextra -O2 -g
+g++ -o sweep sweep.cpp -std=c++17 -lcurl -pthread -Wall -Wextra -O2 -g
+g++ -o trading_daemon daemon.cpp -std=c++17 -lcurl -pthread -Wall -Wextra -O2 -g
@@ -0,0 +1,99 @@
+#ifndef CANDLE_AGGREGATOR_H
+#define CANDLE_AGGREGATOR_H
+
+#include "candle_series.h"
+#include <cstdint>
+#include <ctime>
+
+// Builds OHLCV candles from individual trades at any whole-second
+// granularity, sub-minute included. Buckets are aligned to the epoch like the
+// exchange's own candles, and a bucket without trades produces no candle.
+// Trades may arrive slightly out of order within the open bucket; trades for
+// a bucket that has already been closed are dropped and counted.
+class CandleAggregator {
+public:
+  explicit CandleAggregator(int granularity) : granularity(granularity) {}
+
+  // Adds a trade at `timeMicros` (microseconds since the epoch). When the
+  // trade opens a new bucket, the previous candle is finished into `closed`
+  // and true is returned.
+  bool add(int64_t timeMicros, double price, double size, Candle &closed) {
+    const std::time_t bucket = bucketOf(timeMicros);
+    if (closedAny && bucket <= lastClosed) {
+      ++late;
+      return false;
+    }
+    bool finished = false;
+    if (open && bucket != candle.timestamp) {
+      if (bucket < candle.timestamp) {
+        ++late;
+        return false;
+      }
+      finished = finish(closed);
+    }
+
+    if (!open) {
+      candle = {bucket, price, price, price, price, size};
+      firstTrade = lastTrade = timeMicros;
+      open = true;
+      return finished;
+    }
+
+    if (price > candle.high) {
+      candle.high = price;
+    }
+    if (price < candle.low) {
+      candle.low = price;
+    }
+    if (timeMicros < firstTrade) {
+      firstTrade = timeMicros;
+      candle.open = price;
+    }
+    if (timeMicros >= lastTrade) {
+      lastTrade = timeMicros;
+      candle.closingPrice = price;
+    }
+    candle.volume += size;
+    return finished;
+  }
+
+  // Finishes the open candle once `now` is past its bucket, for quiet
+  // markets where no next trade arrives to close it.
+  bool flush(std::time_t now, Candle &closed) {
+    if (!open || now < candle.timestamp + granularity) {
+      return false;
+    }
+    return finish(closed);
+  }
+
+  bool hasOpen() const { return open; }
+  // The bucket being built; only meaningful while hasOpen().
+  const Candle &current() const { return candle; }
+  size_t lateTrades() const { return late; }
+  int candleGranularity() const { return granularity; }
+
+private:
+  bool finish(Candle &closed) {
+    closed = candle;
+    lastClosed = candle.timestamp;
+    closedAny = true;
+    open = false;
+    return true;
+  }
+
+  std::time_t bucketOf(int64_t timeMicros) const {
+    std::time_t seconds = static_cast<std::time_t>(timeMicros / 1000000);
+    return seconds - seconds % granularity;
+  }
+
+  int granularity;
+  Candle candle{};
+  bool open = false;
+  int64_t firstTrade = 0;
+  int64_t lastTrade = 0;
+  std::time_t lastClosed = 0;
+  bool closedAny = false;
+  size_t late = 0;
+};
+
+#endif // CANDLE_AGGREGATOR_H
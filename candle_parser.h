@@ -0,0 +1,200 @@
+#ifndef CANDLE_PARSER_H
+#define CANDLE_PARSER_H
+
+#include "candle_series.h"
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+
+// Incremental parser for the fixed /candles response shape
+//   [[time, low, high, open, close, volume], ...]
+// Bytes can arrive in arbitrary chunks straight from curl; every finished row
+// is appended to the series without building a DOM or copying the body.
+class CandleParser {
+public:
+  explicit CandleParser(CandleSeries &series)
+      : series(series), firstRow(series.size()) {}
+
+  // curl write callback; userp is the CandleParser. Returning 0 once the
+  // body is known to be bad makes curl abort the transfer.
+  static size_t WriteCallback(void *contents, size_t size, size_t nmemb,
+                              void *userp) {
+    if (!static_cast<CandleParser *>(userp)->feed(
+            static_cast<char *>(contents), size * nmemb)) {
+      return 0;
+    }
+    return size * nmemb;
+  }
+
+  // Feeds the next chunk; returns false once the input is known to be bad.
+  bool feed(const char *data, size_t size) {
+    capturePrefix(data, size);
+    for (size_t i = 0; i < size && state != State::Failed; ++i) {
+      step(data[i]);
+    }
+    return state != State::Failed;
+  }
+
+  // True when exactly one complete top-level array was read. On failure the
+  // rows appended by this parser are dropped again.
+  bool finish() {
+    if (state != State::Done) {
+      if (state != State::Failed) {
+        fail("truncated candle array");
+      }
+      series.truncate(firstRow);
+      return false;
+    }
+    return true;
+  }
+
+  // Drops the rows appended by this parser, e.g. when the response status
+  // says the body is not a candle list even though it parsed.
+  void discard(const char *reason) {
+    fail(reason);
+    series.truncate(firstRow);
+  }
+
+  bool failed() const { return state == State::Failed; }
+  const char *error() const { return message; }
+  size_t rows() const { return series.size() - firstRow; }
+
+  // First bytes of the body, kept so error responses such as
+  // {"message":"..."} can still be reported.
+  const char *bodyPrefix() const { return prefix; }
+
+private:
+  enum class State { Start, Outer, Row, Done, Failed };
+
+  static bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+  }
+
+  static bool isNumberChar(char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' ||
+           c == 'e' || c == 'E';
+  }
+
+  void step(char c) {
+    if (state == State::Row && isNumberChar(c)) {
+      if (numberLength == sizeof(number)) {
+        fail("number too long");
+        return;
+      }
+      number[numberLength++] = c;
+      return;
+    }
+    if (numberLength > 0 && !endNumber()) {
+      return;
+    }
+    if (isSpace(c)) {
+      return;
+    }
+
+    switch (state) {
+    case State::Start:
+      if (c != '[') {
+        fail("expected JSON array");
+        return;
+      }
+      state = State::Outer;
+      series.reserve(firstRow + 300); // Coinbase caps a response at 300 rows
+      break;
+    case State::Outer:
+      if (c == '[' && !haveValue) {
+        state = State::Row;
+        fieldCount = 0;
+        afterComma = false;
+      } else if (c == ']' && !afterComma) {
+        state = State::Done;
+      } else if (c == ',' && haveValue) {
+        haveValue = false;
+        afterComma = true;
+      } else {
+        fail("expected candle row");
+      }
+      break;
+    case State::Row:
+      if (c == ']' && !afterComma) {
+        endRow();
+      } else if (c == ',' && haveValue) {
+        haveValue = false;
+        afterComma = true;
+      } else {
+        fail("empty or unexpected field in candle row");
+      }
+      break;
+    case State::Done:
+      fail("trailing data after candle array");
+      break;
+    case State::Failed:
+      break;
+    }
+  }
+
+  bool endNumber() {
+    double value = 0.0;
+    auto parsed = std::from_chars(number, number + numberLength, value);
+    if (parsed.ec != std::errc() || parsed.ptr != number + numberLength) {
+      fail("malformed number");
+      return false;
+    }
+    if (haveValue) {
+      fail("missing comma between fields");
+      return false;
+    }
+    haveValue = true;
+    afterComma = false;
+    if (fieldCount < 6) {
+      fields[fieldCount] = value;
+    }
+    ++fieldCount;
+    numberLength = 0;
+    return true;
+  }
+
+  void endRow() {
+    if (fieldCount < 6) {
+      fail("candle row has fewer than 6 fields");
+      return;
+    }
+    // Row layout is [time, low, high, open, close, volume].
+    series.append(static_cast<std::time_t>(fields[0]), fields[3], fields[2],
+                  fields[1], fields[4], fields[5]);
+    state = State::Outer;
+    haveValue = true;
+  }
+
+  void fail(const char *reason) {
+    state = State::Failed;
+    message = reason;
+  }
+
+  void capturePrefix(const char *data, size_t size) {
+    size_t room = sizeof(prefix) - 1 - prefixLength;
+    size_t n = size < room ? size : room;
+    std::memcpy(prefix + prefixLength, data, n);
+    prefixLength += n;
+    prefix[prefixLength] = '\0';
+  }
+
+  CandleSeries &series;
+  size_t firstRow;
+  State state = State::Start;
+  const char *message = "";
+
+  double fields[6] = {};
+  size_t fieldCount = 0;
+  // An element (row or field) ended since the last '[' or ','; a ',' was
+  // the last token. Together they reject "[1,,2]", "[1 2]" and "[1,]".
+  bool haveValue = false;
+  bool afterComma = false;
+  char number[32];
+  size_t numberLength = 0;
+
+  char prefix[256] = {};
+  size_t prefixLength = 0;
+};
+
+#endif // CANDLE_PARSER_H
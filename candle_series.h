@@ -0,0 +1,133 @@
+#ifndef CANDLE_SERIES_H
+#define CANDLE_SERIES_H
+
+#include <algorithm>
+#include <cstddef>
+#include <ctime>
+#include <vector>
+
+// One OHLCV bucket as returned by the /candles endpoint.
+struct Candle {
+  std::time_t timestamp;
+  double open;
+  double high;
+  double low;
+  double closingPrice;
+  double volume;
+};
+
+// Read-only view over a contiguous column.
+template <typename T> class Span {
+public:
+  Span() = default;
+  Span(const T *data, size_t size) : ptr(data), count(size) {}
+
+  const T *data() const { return ptr; }
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  const T *begin() const { return ptr; }
+  const T *end() const { return ptr + count; }
+  const T &operator[](size_t i) const { return ptr[i]; }
+  const T &back() const { return ptr[count - 1]; }
+
+  Span subspan(size_t offset, size_t length) const {
+    return Span(ptr + offset, length);
+  }
+
+private:
+  const T *ptr = nullptr;
+  size_t count = 0;
+};
+
+// Candles stored column by column (structure of arrays) so the indicator
+// kernels stream over tightly packed doubles.
+class CandleSeries {
+public:
+  void reserve(size_t n) {
+    times.reserve(n);
+    opens.reserve(n);
+    highs.reserve(n);
+    lows.reserve(n);
+    closes.reserve(n);
+    volumes.reserve(n);
+  }
+
+  void clear() {
+    times.clear();
+    opens.clear();
+    highs.clear();
+    lows.clear();
+    closes.clear();
+    volumes.clear();
+  }
+
+  // Drops every row from index n on.
+  void truncate(size_t n) {
+    if (n >= size()) {
+      return;
+    }
+    times.resize(n);
+    opens.resize(n);
+    highs.resize(n);
+    lows.resize(n);
+    closes.resize(n);
+    volumes.resize(n);
+  }
+
+  void append(std::time_t timestamp, double open, double high, double low,
+              double close, double volume) {
+    times.push_back(timestamp);
+    opens.push_back(open);
+    highs.push_back(high);
+    lows.push_back(low);
+    closes.push_back(close);
+    volumes.push_back(volume);
+  }
+
+  void append(const Candle &candle) {
+    append(candle.timestamp, candle.open, candle.high, candle.low,
+           candle.closingPrice, candle.volume);
+  }
+
+  // Reverses the rows in [from, size()); the API answers newest first.
+  void reverse(size_t from = 0) {
+    std::reverse(times.begin() + from, times.end());
+    std::reverse(opens.begin() + from, opens.end());
+    std::reverse(highs.begin() + from, highs.end());
+    std::reverse(lows.begin() + from, lows.end());
+    std::reverse(closes.begin() + from, closes.end());
+    std::reverse(volumes.begin() + from, volumes.end());
+  }
+
+  size_t size() const { return times.size(); }
+  bool empty() const { return times.empty(); }
+
+  Candle at(size_t i) const {
+    return {times[i], opens[i], highs[i], lows[i], closes[i], volumes[i]};
+  }
+
+  Span<std::time_t> time() const { return {times.data(), times.size()}; }
+  Span<double> open() const { return {opens.data(), opens.size()}; }
+  Span<double> high() const { return {highs.data(), highs.size()}; }
+  Span<double> low() const { return {lows.data(), lows.size()}; }
+  Span<double> close() const { return {closes.data(), closes.size()}; }
+  Span<double> volume() const { return {volumes.data(), volumes.size()}; }
+
+  std::vector<Candle> toCandles() const {
+    std::vector<Candle> candles;
+    candles.reserve(size());
+    for (size_t i = 0; i < size(); ++i)
+      candles.push_back(at(i));
+    return candles;
+  }
+
+private:
+  std::vector<std::time_t> times;
+  std::vector<double> opens;
+  std::vector<double> highs;
+  std::vector<double> lows;
+  std::vector<double> closes;
+  std::vector<double> volumes;
+};
+
+#endif // CANDLE_SERIES_H
@@ -0,0 +1,282 @@
+#ifndef CANDLE_STORE_H
+#define CANDLE_STORE_H
+
+#include "candle_series.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// Append-only on-disk candle cache, one file per product and granularity:
+//   <dir>/<product>-<granularity>.candles
+// A 64-byte header is followed by fixed 48-byte records in strictly
+// increasing time order. Buckets without trades have no candle, so the header
+// also records coveredEnd(): everything before it was fetched, and a window
+// may only be appended if it starts at or before it. A missing stretch is
+// therefore refetched instead of being read back as "no trades". Reads go
+// through a read-only memory map that grows geometrically; a sparse in-memory
+// index of every IndexStride-th timestamp turns a range lookup into two
+// binary searches instead of a parse.
+class CandleStore {
+public:
+  struct Record {
+    int64_t time;
+    double open;
+    double high;
+    double low;
+    double close;
+    double volume;
+  };
+  static_assert(sizeof(Record) == 48, "CandleStore record layout changed");
+
+  CandleStore(const std::string &dir, const std::string &product_id,
+              int granularity)
+      : granularity(granularity) {
+    std::filesystem::create_directories(dir);
+    path = dir + "/" + product_id + "-" + std::to_string(granularity) +
+           ".candles";
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+      throw std::runtime_error("Unable to open candle store " + path + ": " +
+                               std::strerror(errno));
+    }
+
+    struct stat st;
+    fstat(fd, &st);
+    if (st.st_size == 0) {
+      writeHeader();
+    } else {
+      readHeader(static_cast<size_t>(st.st_size));
+    }
+    count = (fileSize - HeaderSize) / sizeof(Record);
+    remap();
+    for (size_t i = 0; i < count; i += IndexStride) {
+      index.push_back(records()[i].time);
+    }
+    // Older files, or a crash between the rows and the header update.
+    if (count > 0) {
+      covered = std::max(covered, lastTime() + granularity);
+    }
+  }
+
+  ~CandleStore() {
+    unmap();
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+
+  CandleStore(const CandleStore &) = delete;
+  CandleStore &operator=(const CandleStore &) = delete;
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  int candleGranularity() const { return granularity; }
+  const std::string &filePath() const { return path; }
+
+  std::time_t firstTime() const {
+    return count ? static_cast<std::time_t>(records()[0].time) : 0;
+  }
+  std::time_t lastTime() const {
+    return count ? static_cast<std::time_t>(records()[count - 1].time) : 0;
+  }
+  // End of the fetched history: buckets before it are either stored or had
+  // no trades. 0 while nothing was appended.
+  std::time_t coveredEnd() const { return covered; }
+
+  Candle at(size_t i) const {
+    const Record &r = records()[i];
+    return {static_cast<std::time_t>(r.time), r.open, r.high, r.low, r.close,
+            r.volume};
+  }
+
+  // First record with time >= t.
+  size_t lowerBound(std::time_t t) const {
+    // The sparse index narrows the search to one stride of records.
+    size_t block = static_cast<size_t>(
+        std::lower_bound(index.begin(), index.end(), static_cast<int64_t>(t)) -
+        index.begin());
+    size_t first = block == 0 ? 0 : (block - 1) * IndexStride;
+    size_t last = std::min(count, block * IndexStride + 1);
+    const Record *base = records();
+    const Record *hit = std::lower_bound(
+        base + first, base + last, static_cast<int64_t>(t),
+        [](const Record &r, int64_t value) { return r.time < value; });
+    return static_cast<size_t>(hit - base);
+  }
+
+  // Appends every cached candle in [start, end) to `out`, oldest first.
+  void range(std::time_t start, std::time_t end, CandleSeries &out) const {
+    size_t first = lowerBound(start);
+    size_t last = lowerBound(end);
+    out.reserve(out.size() + (last - first));
+    for (size_t i = first; i < last; ++i) {
+      out.append(at(i));
+    }
+  }
+
+  // Records the completely fetched window [from, to) whose candles are in
+  // `series`. Rows outside the window or not newer than lastTime() are
+  // skipped so the file stays strictly ordered. Throws if the window starts
+  // after coveredEnd(), which would leave a hole. Returns the number of rows
+  // written.
+  size_t append(const CandleSeries &series, std::time_t from, std::time_t to) {
+    if (covered != 0 && from > covered) {
+      throw std::runtime_error("Candle store " + path + ": window at " +
+                               std::to_string(from) + " leaves a gap after " +
+                               std::to_string(covered));
+    }
+    std::vector<Record> block;
+    std::time_t tail = lastTime();
+    for (size_t i = 0; i < series.size(); ++i) {
+      Candle c = series.at(i);
+      if (c.timestamp < from || c.timestamp >= to ||
+          (count + block.size() > 0 && c.timestamp <= tail)) {
+        continue;
+      }
+      block.push_back({static_cast<int64_t>(c.timestamp), c.open, c.high,
+                       c.low, c.closingPrice, c.volume});
+      tail = c.timestamp;
+    }
+    const size_t written = writeRecords(block);
+    if (to > covered) {
+      covered = to;
+      writeCoverage();
+    }
+    return written;
+  }
+
+private:
+  static constexpr char Magic[8] = {'C', 'N', 'D', 'L', 'S', 'T', 'O', 'R'};
+  static constexpr uint32_t Version = 1;
+  static constexpr size_t HeaderSize = 64;
+  static constexpr size_t IndexStride = 64;
+  static constexpr size_t MinMapping = 1 << 20;
+
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    int64_t granularity;
+    int64_t coveredEnd; // 0 in files written before it existed
+    char reserved[HeaderSize - 32];
+  };
+  static_assert(sizeof(Header) == HeaderSize, "CandleStore header size");
+
+  void writeHeader() {
+    Header header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.recordSize = sizeof(Record);
+    header.granularity = granularity;
+    if (pwrite(fd, &header, sizeof(header), 0) !=
+        static_cast<ssize_t>(sizeof(header))) {
+      throw std::runtime_error("Unable to write candle store header " + path);
+    }
+    fileSize = HeaderSize;
+  }
+
+  void readHeader(size_t size) {
+    Header header{};
+    if (size < HeaderSize ||
+        pread(fd, &header, sizeof(header), 0) !=
+            static_cast<ssize_t>(sizeof(header)) ||
+        std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+        header.version != Version || header.recordSize != sizeof(Record) ||
+        header.granularity != granularity) {
+      throw std::runtime_error("Not a compatible candle store: " + path);
+    }
+    covered = static_cast<std::time_t>(header.coveredEnd);
+    // Drop a torn trailing record left by an interrupted append.
+    size_t whole = HeaderSize + (size - HeaderSize) / sizeof(Record) *
+                                    sizeof(Record);
+    if (whole != size && ftruncate(fd, static_cast<off_t>(whole)) != 0) {
+      throw std::runtime_error("Unable to repair candle store " + path);
+    }
+    fileSize = whole;
+  }
+
+  void writeCoverage() {
+    const int64_t value = static_cast<int64_t>(covered);
+    if (pwrite(fd, &value, sizeof(value), offsetof(Header, coveredEnd)) !=
+        static_cast<ssize_t>(sizeof(value))) {
+      throw std::runtime_error("Unable to update candle store header " + path);
+    }
+  }
+
+  size_t writeRecords(const std::vector<Record> &block) {
+    if (block.empty()) {
+      return 0;
+    }
+    const size_t bytes = block.size() * sizeof(Record);
+    ssize_t written = pwrite(fd, block.data(), bytes,
+                             static_cast<off_t>(fileSize));
+    if (written != static_cast<ssize_t>(bytes)) {
+      // Leave the file on a record boundary.
+      if (ftruncate(fd, static_cast<off_t>(fileSize)) != 0) {
+        throw std::runtime_error("Unable to repair candle store " + path);
+      }
+      throw std::runtime_error("Unable to append to candle store " + path);
+    }
+    for (size_t i = 0; i < block.size(); ++i) {
+      if ((count + i) % IndexStride == 0) {
+        index.push_back(block[i].time);
+      }
+    }
+    fileSize += bytes;
+    count += block.size();
+    remap();
+    return block.size();
+  }
+
+  // The mapping may extend past the end of the file; pages appended later
+  // show up in it, so it is only replaced when the file outgrows it. Only
+  // the first `count` records are ever read.
+  void remap() {
+    if (mapping && fileSize <= mappedSize) {
+      return;
+    }
+    const size_t size = std::max({fileSize, mappedSize * 2, MinMapping});
+    unmap();
+    mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+      mapping = nullptr;
+      throw std::runtime_error("Unable to map candle store " + path);
+    }
+    mappedSize = size;
+  }
+
+  void unmap() {
+    if (mapping) {
+      munmap(mapping, mappedSize);
+      mapping = nullptr;
+    }
+  }
+
+  const Record *records() const {
+    return reinterpret_cast<const Record *>(static_cast<const char *>(mapping) +
+                                            HeaderSize);
+  }
+
+  int granularity;
+  std::string path;
+  int fd = -1;
+  size_t fileSize = 0;
+  size_t count = 0;
+  std::time_t covered = 0;
+  void *mapping = nullptr;
+  size_t mappedSize = 0;
+  std::vector<int64_t> index; // time of every IndexStride-th record
+};
+
+#endif // CANDLE_STORE_H
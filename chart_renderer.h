@@ -0,0 +1,251 @@
+#ifndef CHART_RENDERER_H
+#define CHART_RENDERER_H
+
+#include "operations.h"
+#include "price_scale.h"
+#include "result_history.h"
+#include "raylib.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Draws the price series in world space for the 2D camera. Only the indices
+// inside the camera's view are visited, and when several points share a
+// screen pixel the series is drawn from a min/max pyramid (block sizes 2, 4,
+// 8, ...) maintained as results arrive. The line always goes out as a single
+// DrawLineStrip, so frame cost follows the screen width, not the history.
+// Prices are normalized at draw time against a PriceScale that is updated
+// as results arrive, and the strip is only rebuilt when the view, the data
+// or the scale changed since the last frame.
+class ChartRenderer {
+public:
+  // scaleWindow 0 scales over the whole history; otherwise over the latest
+  // scaleWindow points, so the live tail keeps filling the chart's height.
+  explicit ChartRenderer(size_t scaleWindow = 0) : scale(scaleWindow) {}
+
+  static Color signalColor(Signal signal) {
+    if (signal == Signal::Hold)
+      return RED; //{27, 38, 49, 255};
+    else if (signal == Signal::Buy)
+      return DARKGREEN;
+    return DARKBLUE; //{244, 208, 63, 255};
+  }
+
+  // Extends the pyramid with results appended since the last call.
+  void sync(const ResultHistory &results) {
+    if (results.size() < synced) {
+      reset();
+    }
+    if (priceLabels.size() != results.capacity()) {
+      priceLabels.assign(results.capacity(), {});
+    }
+    for (; synced < results.size(); ++synced) {
+      const double price = results[synced].price;
+      push(price);
+      formatLabel(price, priceLabels[synced % priceLabels.size()]);
+    }
+    if (!results.empty()) {
+      spacing = static_cast<float>(results.front().normalized_timestamp);
+    }
+  }
+
+  // World position of point i, normalized the same way
+  // Operations::normalizeData does (over the scale window, if one is set).
+  Vector2 pointPosition(size_t i, double price, int screenHeight) const {
+    float x = spacing * static_cast<float>(i + 2);
+    return {x, toY(price, screenHeight)};
+  }
+
+  // Call between BeginMode2D/EndMode2D.
+  void draw(const ResultHistory &results, const Camera2D &camera,
+            int screenWidth, int screenHeight) {
+    sync(results);
+    if (results.empty() || spacing <= 0.0f) {
+      return;
+    }
+
+    const float left = GetScreenToWorld2D({0.0f, 0.0f}, camera).x;
+    const float right =
+        GetScreenToWorld2D({static_cast<float>(screenWidth), 0.0f}, camera).x;
+    long first = static_cast<long>(std::floor(left / spacing)) - 3;
+    long last = static_cast<long>(std::ceil(right / spacing)) - 1;
+    first = std::max(first, 0L);
+    last = std::min(last, static_cast<long>(results.size()) - 1);
+    if (first > last) {
+      return;
+    }
+
+    const float pixelsPerPoint = spacing * camera.zoom;
+
+    // Largest block size (as a power of two) that still fits in one pixel.
+    size_t level = 0;
+    if (pixelsPerPoint < 1.0f) {
+      level = static_cast<size_t>(std::log2(1.0f / pixelsPerPoint));
+      level = std::min(level, levels.size());
+    }
+
+    // The strip only depends on the visible points and the scale, so it is
+    // rebuilt when one of them changed, not every frame.
+    const StripKey key{first, last, level, synced, scale.version(),
+                       screenHeight, spacing};
+    if (!(key == built)) {
+      vertices.clear();
+      if (level == 0) {
+        for (long i = first; i <= last; ++i) {
+          vertices.push_back(pointPosition(static_cast<size_t>(i),
+                                           results[i].price, screenHeight));
+        }
+      } else {
+        drawBlocks(level, static_cast<size_t>(first),
+                   static_cast<size_t>(last), screenHeight);
+      }
+      built = key;
+    }
+
+    if (vertices.size() >= 2) {
+      DrawLineStrip(vertices.data(), static_cast<int>(vertices.size()), WHITE);
+    }
+
+    // Markers and labels only when the points are far enough apart to read.
+    if (pixelsPerPoint >= 4.0f) {
+      const int fontsize = 12;
+      for (long i = first; i <= last; ++i) {
+        const Result res = results[i];
+        Vector2 p = pointPosition(static_cast<size_t>(i), res.price,
+                                  screenHeight);
+        DrawCircleV(p, 3, RED);
+        if (pixelsPerPoint >= LabelSpacing) {
+          Color color = signalColor(res.signal);
+          DrawText(signalName(res.signal), p.x + 3, p.y, fontsize, color);
+          DrawText(label(static_cast<size_t>(i), res.price), p.x + 3, p.y + 16,
+                   fontsize, color);
+        }
+      }
+    }
+  }
+
+private:
+  static constexpr float LabelSpacing = 40.0f; // min pixels between labels
+
+  // Everything the cached strip depends on.
+  struct StripKey {
+    long first;
+    long last;
+    size_t level;
+    size_t synced;
+    uint64_t scaleVersion;
+    int screenHeight;
+    float spacing;
+
+    bool operator==(const StripKey &other) const {
+      return first == other.first && last == other.last &&
+             level == other.level && synced == other.synced &&
+             scaleVersion == other.scaleVersion &&
+             screenHeight == other.screenHeight && spacing == other.spacing;
+    }
+  };
+
+  using Label = std::array<char, 32>;
+
+  // Price labels are formatted once, when the point arrives, in the same
+  // notation as std::to_string. Like the results, only the newest
+  // capacity() labels are kept; older ones are formatted when shown.
+  static void formatLabel(double price, Label &label) {
+    label.fill('\0');
+    auto written = std::to_chars(label.data(), label.data() + label.size() - 1,
+                                 price, std::chars_format::fixed, 6);
+    if (written.ec != std::errc()) {
+      label[0] = '?';
+    }
+  }
+
+  const char *label(size_t i, double price) {
+    if (i + priceLabels.size() >= synced) {
+      return priceLabels[i % priceLabels.size()].data();
+    }
+    formatLabel(price, spilledLabel);
+    return spilledLabel.data();
+  }
+
+  void reset() {
+    levels.clear();
+    synced = 0;
+    scale.clear();
+    built = {};
+  }
+
+  void push(double price) {
+    const size_t index = synced;
+    if (index == 0) {
+      levels.emplace_back();
+    }
+    scale.push(price);
+
+    // levels[k] holds the min/max of consecutive blocks of 2^(k+1) points.
+    for (size_t k = 0; k < levels.size(); ++k) {
+      auto &level = levels[k];
+      size_t block = index >> (k + 1);
+      if (block == level.size()) {
+        level.push_back({price, price});
+      } else {
+        level[block].first = std::min(level[block].first, price);
+        level[block].second = std::max(level[block].second, price);
+      }
+    }
+
+    // Grow a coarser level once the series is long enough to fill a block.
+    while ((size_t{1} << (levels.size() + 1)) <= index + 1) {
+      const auto &below = levels.back();
+      std::vector<std::pair<double, double>> level;
+      level.reserve(below.size() / 2 + 1);
+      for (size_t j = 0; j < below.size(); j += 2) {
+        auto merged = below[j];
+        if (j + 1 < below.size()) {
+          merged.first = std::min(merged.first, below[j + 1].first);
+          merged.second = std::max(merged.second, below[j + 1].second);
+        }
+        level.push_back(merged);
+      }
+      levels.push_back(std::move(level));
+    }
+  }
+
+  float toY(double price, int screenHeight) const {
+    return static_cast<float>(screenHeight - scale.normalize(price) *
+                                                 (screenHeight / 2.0f));
+  }
+
+  void drawBlocks(size_t level, size_t first, size_t last, int screenHeight) {
+    const auto &blocks = levels[level - 1];
+    const size_t blockSize = size_t{1} << level;
+    size_t begin = first / blockSize;
+    size_t end = std::min(last / blockSize, blocks.size() - 1);
+    for (size_t b = begin; b <= end; ++b) {
+      float x = spacing * (static_cast<float>(b * blockSize) +
+                           blockSize / 2.0f + 2.0f);
+      float yLow = toY(blocks[b].first, screenHeight);
+      float yHigh = toY(blocks[b].second, screenHeight);
+      // Alternate the order so neighbouring blocks join without long slants.
+      if (b % 2 == 0) {
+        std::swap(yLow, yHigh);
+      }
+      vertices.push_back({x, yLow});
+      vertices.push_back({x, yHigh});
+    }
+  }
+
+  std::vector<std::vector<std::pair<double, double>>> levels;
+  std::vector<Label> priceLabels; // ring over the in-memory results
+  Label spilledLabel{};
+  std::vector<Vector2> vertices; // the strip for `built`
+  StripKey built{};
+  size_t synced = 0;
+  float spacing = 0.0f;
+  PriceScale scale;
+};
+
+#endif // CHART_RENDERER_H
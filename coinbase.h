@@ -1,143 +1,370 @@
 #ifndef COINBASE_H
 #define COINBASE_H
 
+#include "candle_parser.h"
+#include "candle_series.h"
 #include <curl/curl.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
 #include <iostream>
-#include <json/json.h>
-#include <sstream>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <vector>
 #include <ctime>
 
 class Coinbase {
 
-private: // Callback to store API response
-  static size_t WriteCallback(void *contents, size_t size, size_t nmemb,
-                              void *userp) {
-    ((std::string *)userp)->append((char *)contents, size * nmemb);
-    return size * nmemb;
+private:
+  // DNS and TLS session caches shared by every handle in the process, so a
+  // new handle still skips the lookup and most of the handshake. The
+  // connection cache is not shared: libcurl does not support that across
+  // threads, so connections are kept per easy handle (and per multi handle
+  // for fetchMany), each of which only one thread uses.
+  class SharedCache {
+  public:
+    SharedCache() {
+      curl_global_init(CURL_GLOBAL_DEFAULT);
+      share = curl_share_init();
+      curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lock);
+      curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlock);
+      curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+      curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+      curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+
+    CURLSH *handle() const { return share; }
+
+  private:
+    static void lock(CURL *, curl_lock_data data, curl_lock_access,
+                     void *userp) {
+      static_cast<SharedCache *>(userp)->mutexes[data % CURL_LOCK_DATA_LAST]
+          .lock();
+    }
+    static void unlock(CURL *, curl_lock_data data, void *userp) {
+      static_cast<SharedCache *>(userp)->mutexes[data % CURL_LOCK_DATA_LAST]
+          .unlock();
+    }
+
+    CURLSH *share;
+    std::mutex mutexes[CURL_LOCK_DATA_LAST];
+  };
+
+  // Never destroyed: easy handles owned by other statics or threads may
+  // still point at the share during static destruction.
+  static CURLSH *sharedCache() {
+    static SharedCache *cache = new SharedCache;
+    return cache->handle();
+  }
+
+  const std::string &candlesUrl(const std::string &product_id, int granularity,
+                                time_t start, time_t end) {
+    candlesUrl(product_id, granularity);
+    url += "&start=";
+    url += std::to_string(start);
+    url += "&end=";
+    url += std::to_string(end);
+    return url;
+  }
+
+  // Rebuilt in place; the buffer keeps its capacity between requests.
+  const std::string &candlesUrl(const std::string &product_id,
+                                int granularity) {
+    url.clear();
+    url += baseUrl;
+    url += "/products/";
+    url += product_id;
+    url += "/candles?granularity=";
+    url += std::to_string(granularity);
+    return url;
+  }
+
+  // Options every handle of this client shares.
+  void configure(CURL *handle) {
+    curl_easy_setopt(handle, CURLOPT_SHARE, sharedCache());
+    curl_easy_setopt(handle, CURLOPT_HTTPGET, 1L);
+    curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(handle, CURLOPT_DEFAULT_PROTOCOL, "https");
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, CandleParser::WriteCallback);
+    curl_easy_setopt(handle, CURLOPT_TIMEOUT, 10L); // bounded stall for the fetch worker
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(handle, CURLOPT_TCP_NODELAY, 1L);
+  }
+
+  void recordTiming(CURL *handle, long &http_code, double &latencyMs) {
+    long connects = 0;
+    curl_off_t total_us = 0;
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &http_code);
+    curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &connects);
+    curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME_T, &total_us);
+    latencyMs = total_us / 1000.0;
+    stats.requests++;
+    stats.connectionsOpened += static_cast<size_t>(connects);
+    stats.lastLatencyMs = latencyMs;
+    stats.totalLatencyMs += latencyMs;
+  }
+
+  // Streams the response body through the candle parser as curl delivers it.
+  // The easy handle is reused, so steady-state polling rides one warm
+  // keep-alive connection.
+  bool performRequest(const std::string &requestUrl, CandleParser &parser) {
+    if (!curl) {
+      return false;
+    }
+    curl_easy_setopt(curl, CURLOPT_URL, requestUrl.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &parser);
+    CURLcode res = curl_easy_perform(curl);
+
+    long http_code = 0;
+    double latencyMs = 0.0;
+    recordTiming(curl, http_code, latencyMs);
+
+    // A parse failure aborts the transfer, so a write error is reported as
+    // the parse error (or the HTTP status) behind it.
+    if (res != CURLE_OK && !parser.failed()) {
+      std::cerr << "Error: " << curl_easy_strerror(res) << std::endl;
+      parser.finish();
+      return false;
+    }
+    if (http_code != 200) {
+      parser.discard("unexpected HTTP status");
+      std::cerr << "Request failed (HTTP " << http_code
+                << "): " << parser.bodyPrefix() << std::endl;
+      return false;
+    }
+    if (!parser.finish()) {
+      std::cerr << "Candle Parse Error (HTTP " << http_code
+                << "): " << parser.error() << " : " << parser.bodyPrefix()
+                << std::endl;
+      return false;
+    }
+    return true;
   }
 
 public:
-  struct Candle {
-      std::time_t timestamp;
-      double closingPrice;
+  using Candle = ::Candle;
+
+  struct RequestStats {
+    size_t requests = 0;
+    size_t connectionsOpened = 0; // new TCP/TLS connections, not reuses
+    double lastLatencyMs = 0.0;
+    double totalLatencyMs = 0.0;
   };
-  std::vector<Candle> fetchCoinbaseData(const std::string &product_id, int granularity, time_t start, time_t end) {
-  std::string url = "https://api.exchange.coinbase.com/products/" +
-                      product_id +"/candles?granularity=" + std::to_string(granularity)+"&start="+std::to_string(start)+"&end="+std::to_string(end);
-
-  std::cout << "API URL : " << url << std::endl;
-
-  CURL *curl;
-  CURLcode res;
-  std::string readBuffer;
-
-  curl = curl_easy_init();
-  if(curl) {
-      curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "GET");
-      curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-      curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-      curl_easy_setopt(curl, CURLOPT_DEFAULT_PROTOCOL, "https");
-      struct curl_slist *headers = NULL;
-      headers = curl_slist_append(headers, "Content-Type: application/json");
-      headers = curl_slist_append(headers, "User-Agent: Mozilla/5.0");
-      curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-      curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-      curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
-      res = curl_easy_perform(curl);
-      if (res != CURLE_OK) {
-          std::cerr << "Error: " << curl_easy_strerror(res) << std::endl;
-          return {};
-      }
-      curl_slist_free_all(headers);
+
+  explicit Coinbase(const std::string &base_url =
+                        "https://api.exchange.coinbase.com")
+      : baseUrl(base_url) {
+    curl = curl_easy_init();
+    if (!curl) {
+      std::cerr << "Error: curl_easy_init failed" << std::endl;
+      return;
+    }
+    headers = curl_slist_append(headers, "Content-Type: application/json");
+    headers = curl_slist_append(headers, "User-Agent: Mozilla/5.0");
+    configure(curl);
+
+    url.reserve(256);
+    responseSeries.reserve(300);
   }
-  curl_easy_cleanup(curl);
-
-  // Print the raw response for debugging
-  //std::cout << "API Response: " << readBuffer << std::endl;
-
-  // Parse the JSON response
-  Json::Value jsonData;
-  Json::CharReaderBuilder builder;
-  std::istringstream stream(readBuffer);
-  std::string errs;
-  std::vector<Candle> candles;
-
-  if (Json::parseFromStream(builder, stream, &jsonData, &errs)) {
-    if (jsonData.isArray()) {
-      for (const auto &candle : jsonData) {
-        Candle c;
-        c.timestamp = static_cast<time_t>(candle[0].asInt64()); // Convert timestamp to time_t
-        c.closingPrice = candle[4].asDouble(); 
-        candles.push_back(c);
-      }
-    } else {
-      std::cerr << "Error: Expected JSON array, but received something else : " << jsonData << std::endl;
+
+  ~Coinbase() {
+    for (auto &transfer : transfers) {
+      curl_easy_cleanup(transfer.curl);
     }
-  } else {
-    std::cerr << "JSON Parse Error: " << errs << std::endl;
+    if (multi) {
+      curl_multi_cleanup(multi);
+    }
+    if (curl) {
+      curl_easy_cleanup(curl);
+    }
+    curl_slist_free_all(headers);
   }
 
-  return candles;
-}
+  Coinbase(const Coinbase &) = delete;
+  Coinbase &operator=(const Coinbase &) = delete;
 
+  const RequestStats &requestStats() const { return stats; }
 
-std::vector<Candle> fetchCoinbaseData(const std::string &product_id, int granularity) {
-  std::string url = "https://api.exchange.coinbase.com/products/" +
-                    product_id +"/candles?granularity=" + std::to_string(granularity);
-  CURL *curl;
-  CURLcode res;
-  std::string readBuffer;
+  struct FetchRequest {
+    std::string productId;
+    int granularity = 60;
+    time_t start = 0; // 0/0 asks for the most recent window
+    time_t end = 0;
+  };
 
-  curl = curl_easy_init();
-  if (curl) {
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
-    res = curl_easy_perform(curl);
-    
-    long http_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-    
-    curl_easy_cleanup(curl);
+  struct FetchResult {
+    size_t index = 0; // position in the request list
+    std::string productId;
+    int granularity = 0;
+    bool ok = false;
+    long httpCode = 0;
+    double latencyMs = 0.0;
+    std::string error;
+    CandleSeries candles; // oldest first
+  };
 
-    if (res != CURLE_OK) {
-      return {};
+  using ResultCallback = std::function<void(const FetchResult &)>;
+
+  // Caps how many requests per second this client starts (0 = unlimited);
+  // honoured by fetchMany. Coinbase allows roughly 10/s on public endpoints.
+  void setRateLimit(double requests_per_second) {
+    requestsPerSecond = requests_per_second;
+  }
+
+  // Runs every request through one curl_multi event loop with at most
+  // `maxInFlight` transfers open at once. `onResult` fires in completion
+  // order; the returned vector is in request order.
+  std::vector<FetchResult> fetchMany(const std::vector<FetchRequest> &requests,
+                                     size_t maxInFlight = 8,
+                                     const ResultCallback &onResult = nullptr) {
+    std::vector<FetchResult> results(requests.size());
+    if (requests.empty()) {
+      return results;
+    }
+    if (!multi) {
+      multi = curl_multi_init();
+      curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    }
+    maxInFlight = std::max<size_t>(1, std::min(maxInFlight, requests.size()));
+    while (transfers.size() < maxInFlight) {
+      Transfer transfer;
+      transfer.curl = curl_easy_init();
+      configure(transfer.curl);
+      transfers.push_back(std::move(transfer));
     }
 
-    if (http_code != 200) {
-      return {};
+    size_t next = 0;
+    size_t running = 0;
+    auto startNext = [&](Transfer &transfer) {
+      if (next == requests.size()) {
+        return;
+      }
+      const FetchRequest &request = requests[next];
+      FetchResult &result = results[next];
+      result.index = next;
+      result.productId = request.productId;
+      result.granularity = request.granularity;
+      result.candles.reserve(300);
+
+      transfer.index = next++;
+      transfer.url = (request.start || request.end)
+                         ? candlesUrl(request.productId, request.granularity,
+                                      request.start, request.end)
+                         : candlesUrl(request.productId, request.granularity);
+      transfer.parser.emplace(result.candles);
+      curl_easy_setopt(transfer.curl, CURLOPT_URL, transfer.url.c_str());
+      curl_easy_setopt(transfer.curl, CURLOPT_WRITEDATA, &*transfer.parser);
+      curl_easy_setopt(transfer.curl, CURLOPT_PRIVATE, &transfer);
+      curl_multi_add_handle(multi, transfer.curl);
+      running++;
+    };
+
+    // Transfers wait here until the rate budget allows their next start.
+    std::vector<Transfer *> idle;
+    for (size_t i = 0; i < maxInFlight; ++i) {
+      idle.push_back(&transfers[i]);
     }
-  }
+    const auto interval = std::chrono::duration_cast<
+        std::chrono::steady_clock::duration>(std::chrono::duration<double>(
+        requestsPerSecond > 0.0 ? 1.0 / requestsPerSecond : 0.0));
 
-  // Print the raw response for debugging
-  //std::cout << "API Response: " << readBuffer << std::endl;
-
-  // Parse the JSON response
-  Json::Value jsonData;
-  Json::CharReaderBuilder builder;
-  std::istringstream stream(readBuffer);
-  std::string errs;
-  std::vector<Candle> candles;
-
-  if (Json::parseFromStream(builder, stream, &jsonData, &errs)) {
-    if (jsonData.isArray()) {
-      for (const auto &candle : jsonData) {
-        Candle c;
-        c.timestamp = static_cast<time_t>(candle[0].asInt64()); // Convert timestamp to time_t
-        c.closingPrice = candle[4].asDouble(); // Extract "close" price
-        candles.push_back(c);
+    while (running > 0 || next < requests.size()) {
+      auto now = std::chrono::steady_clock::now();
+      while (!idle.empty() && next < requests.size() && now >= nextSlot) {
+        startNext(*idle.back());
+        idle.pop_back();
+        nextSlot = std::max(nextSlot, now) + interval;
       }
-    } else {
-      std::cerr << "Error: Expected JSON array, but received something else." << std::endl;
+
+      int stillRunning = 0;
+      curl_multi_perform(multi, &stillRunning);
+
+      int queued = 0;
+      while (CURLMsg *msg = curl_multi_info_read(multi, &queued)) {
+        if (msg->msg != CURLMSG_DONE) {
+          continue;
+        }
+        Transfer *transfer = nullptr;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &transfer);
+        FetchResult &result = results[transfer->index];
+
+        recordTiming(transfer->curl, result.httpCode, result.latencyMs);
+        const bool badBody = transfer->parser->failed();
+        bool parsed = transfer->parser->finish();
+        if (msg->data.result != CURLE_OK && !badBody) {
+          result.error = curl_easy_strerror(msg->data.result);
+        } else if (result.httpCode != 200) {
+          transfer->parser->discard("unexpected HTTP status");
+          result.error = "HTTP " + std::to_string(result.httpCode) + " : " +
+                         transfer->parser->bodyPrefix();
+        } else if (!parsed) {
+          result.error = std::string(transfer->parser->error()) + " : " +
+                         transfer->parser->bodyPrefix();
+        } else {
+          result.ok = true;
+          result.candles.reverse();
+        }
+        transfer->parser.reset();
+
+        curl_multi_remove_handle(multi, transfer->curl);
+        running--;
+        idle.push_back(transfer);
+        if (onResult) {
+          onResult(result);
+        }
+      }
+
+      int timeoutMs = 1000;
+      if (!idle.empty() && next < requests.size()) {
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+            nextSlot - std::chrono::steady_clock::now());
+        timeoutMs = static_cast<int>(
+            std::max<long long>(0, std::min<long long>(1000, wait.count())));
+      }
+      if (running > 0 || (next < requests.size() && timeoutMs > 0)) {
+        curl_multi_poll(multi, nullptr, 0, timeoutMs, nullptr);
+      }
+    }
+    return results;
+  }
+
+  // Appends the [start, end] window to `series`, oldest first.
+  bool fetchCoinbaseData(const std::string &product_id, int granularity,
+                         time_t start, time_t end, CandleSeries &series) {
+    const size_t first = series.size();
+    CandleParser parser(series);
+    if (!performRequest(candlesUrl(product_id, granularity, start, end),
+                        parser)) {
+      return false;
+    }
+    series.reverse(first);
+    return true;
+  }
+
+  // Returns the window newest first, as the API orders it.
+  std::vector<Candle> fetchCoinbaseData(const std::string &product_id, int granularity, time_t start, time_t end) {
+    const std::string &url = candlesUrl(product_id, granularity, start, end);
+
+    std::cout << "API URL : " << url << std::endl;
+
+    responseSeries.clear();
+    CandleParser parser(responseSeries);
+    if (!performRequest(url, parser)) {
+      return {};
     }
-  } else {
-    std::cerr << "JSON Parse Error: " << errs << std::endl;
+    return responseSeries.toCandles();
   }
 
-  return candles;
-}
+  std::vector<Candle> fetchCoinbaseData(const std::string &product_id, int granularity) {
+    responseSeries.clear();
+    CandleParser parser(responseSeries);
+    if (!performRequest(candlesUrl(product_id, granularity), parser)) {
+      return {};
+    }
+    return responseSeries.toCandles();
+  }
 
   void printCandleData(const std::vector<Candle>& candles) {
     for (const auto &candle : candles) {
@@ -145,5 +372,25 @@ std::vector<Candle> fetchCoinbaseData(const std::string &product_id, int granula
                 << "Closing Price: " << candle.closingPrice << std::endl;
     }
   }
+
+private:
+  // One pooled easy handle of the multi interface.
+  struct Transfer {
+    CURL *curl = nullptr;
+    size_t index = 0;
+    std::string url;
+    std::optional<CandleParser> parser;
+  };
+
+  std::string baseUrl;
+  CURL *curl = nullptr;
+  CURLM *multi = nullptr;
+  std::vector<Transfer> transfers; // reused across fetchMany calls
+  double requestsPerSecond = 0.0;
+  std::chrono::steady_clock::time_point nextSlot;
+  struct curl_slist *headers = NULL;
+  std::string url;             // request URL, rebuilt in place
+  CandleSeries responseSeries; // parse target for the vector overloads
+  RequestStats stats;
 };
 #endif
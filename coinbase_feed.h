@@ -0,0 +1,646 @@
+#ifndef COINBASE_FEED_H
+#define COINBASE_FEED_H
+
+#include <curl/curl.h>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Streaming market data from the Coinbase Exchange WebSocket feed, the push
+// counterpart of the REST polling in Coinbase. Subscribes to the `matches`
+// (or `ticker`) channel and hands every trade to a callback as it arrives.
+// curl only opens the connection (TCP and TLS, CURLOPT_CONNECT_ONLY); the
+// upgrade and the RFC 6455 framing are done here, because curl's own
+// WebSocket support is still experimental and missing from most builds.
+// Messages are parsed in place without building a JSON tree.
+class CoinbaseFeed {
+public:
+  struct Trade {
+    std::string_view productId; // valid only inside the callback
+    int64_t timeMicros;         // exchange time, microseconds since the epoch
+    double price;
+    double size;
+    uint64_t tradeId;
+  };
+
+  explicit CoinbaseFeed(
+      const std::string &url = "wss://ws-feed.exchange.coinbase.com")
+      : url(url) {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    input.reserve(sizeof(buffer) * 2);
+    message.reserve(4096);
+  }
+
+  ~CoinbaseFeed() { disconnect(); }
+
+  CoinbaseFeed(const CoinbaseFeed &) = delete;
+  CoinbaseFeed &operator=(const CoinbaseFeed &) = delete;
+
+  // Connects and performs the WebSocket upgrade.
+  bool connect() {
+    disconnect();
+    std::string host;
+    std::string target;
+    std::string httpUrl;
+    if (!splitUrl(host, target, httpUrl)) {
+      std::cerr << "Feed: unsupported URL " << url << std::endl;
+      return false;
+    }
+    curl = curl_easy_init();
+    if (!curl) {
+      return false;
+    }
+    curl_easy_setopt(curl, CURLOPT_URL, httpUrl.c_str());
+    curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_NODELAY, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L);
+    CURLcode res = curl_easy_perform(curl);
+    if (res != CURLE_OK) {
+      std::cerr << "Feed connect failed: " << curl_easy_strerror(res)
+                << std::endl;
+      disconnect();
+      return false;
+    }
+    curl_easy_getinfo(curl, CURLINFO_ACTIVESOCKET, &socket);
+
+    const std::string key = handshakeKey();
+
+    std::string request = "GET " + target + " HTTP/1.1\r\n"
+                          "Host: " + host + "\r\n"
+                          "User-Agent: TradingAnalysis/1.0\r\n"
+                          "Upgrade: websocket\r\n"
+                          "Connection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: " + key + "\r\n"
+                          "Sec-WebSocket-Version: 13\r\n\r\n";
+    if (!writeAll(request.data(), request.size()) || !readUpgrade(key)) {
+      disconnect();
+      return false;
+    }
+    return true;
+  }
+
+  void disconnect() {
+    if (curl) {
+      curl_easy_cleanup(curl);
+      curl = nullptr;
+    }
+    socket = CURL_SOCKET_BAD;
+    input.clear();
+    message.clear();
+  }
+
+  bool connected() const { return curl != nullptr; }
+
+  // channel is "matches" (every trade) or "ticker" (one per match, with the
+  // best bid/ask as well).
+  bool subscribe(const std::vector<std::string> &product_ids,
+                 const std::string &channel = "matches") {
+    std::string request = "{\"type\":\"subscribe\",\"product_ids\":[";
+    for (size_t i = 0; i < product_ids.size(); ++i) {
+      request += i ? ",\"" : "\"";
+      request += product_ids[i];
+      request += "\"";
+    }
+    request += "],\"channels\":[\"";
+    request += channel;
+    request += "\"]}";
+    return sendFrame(OpText, request.data(), request.size());
+  }
+
+  // Waits up to timeoutMs for data, then dispatches every complete trade
+  // message to onTrade(const Trade &). Returns false once the connection is
+  // closed or fails.
+  template <typename OnTrade> bool poll(int timeoutMs, OnTrade onTrade) {
+    // Frames that came with the upgrade response, or that curl's TLS layer
+    // already decrypted, are not signalled by the socket; hand those out
+    // first.
+    size_t before = messageCount;
+    if (!input.empty() && !dispatch(onTrade)) {
+      disconnect();
+      return false;
+    }
+    if (!drain(onTrade) || messageCount != before) {
+      return connected();
+    }
+    pollfd fd{static_cast<int>(socket), POLLIN, 0};
+    if (::poll(&fd, 1, timeoutMs) < 0 && errno != EINTR) {
+      std::cerr << "Feed poll failed: " << std::strerror(errno) << std::endl;
+      disconnect();
+      return false;
+    }
+    drain(onTrade);
+    return connected();
+  }
+
+  // Decodes a `match`, `last_match` or `ticker` message. Other message
+  // types (subscriptions, heartbeats, errors) return false.
+  static bool parseTrade(const char *data, size_t size, Trade &trade) {
+    std::string_view msg(data, size);
+    std::string_view type = field(msg, "type");
+    const bool ticker = type == "ticker";
+    if (type != "match" && type != "last_match" && !ticker) {
+      if (type == "error") {
+        std::cerr << "Feed error: " << msg << std::endl;
+      }
+      return false;
+    }
+
+    std::string_view size_text = field(msg, ticker ? "last_size" : "size");
+    trade.productId = field(msg, "product_id");
+    trade.tradeId = 0;
+    std::string_view id = number(msg, "trade_id");
+    std::from_chars(id.data(), id.data() + id.size(), trade.tradeId);
+    return parseDouble(field(msg, "price"), trade.price) &&
+           parseDouble(size_text, trade.size) &&
+           parseTime(field(msg, "time"), trade.timeMicros);
+  }
+
+  // "2014-11-07T08:19:27.028459Z" to microseconds since the epoch.
+  static bool parseTime(std::string_view text, int64_t &micros) {
+    int year, month, day, hour, minute, second;
+    if (text.size() < 20 || !digits(text, 0, 4, year) ||
+        !digits(text, 5, 2, month) || !digits(text, 8, 2, day) ||
+        !digits(text, 11, 2, hour) || !digits(text, 14, 2, minute) ||
+        !digits(text, 17, 2, second)) {
+      return false;
+    }
+    int64_t fraction = 0;
+    size_t i = 19;
+    int scale = 1000000;
+    if (i < text.size() && text[i] == '.') {
+      for (++i; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i) {
+        if (scale > 1) {
+          scale /= 10;
+          fraction += (text[i] - '0') * scale;
+        }
+      }
+    }
+    const int64_t days = daysFromCivil(year, month, day);
+    micros = ((days * 24 + hour) * 60 + minute) * 60 + second;
+    micros = micros * 1000000 + fraction;
+    return true;
+  }
+
+  // Sec-WebSocket-Accept the server must answer `key` with (RFC 6455 4.2.2):
+  // base64(SHA-1(key + GUID)).
+  static std::string acceptFor(std::string_view key) {
+    std::string input(key);
+    input += "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    unsigned char digest[20];
+    sha1(reinterpret_cast<const unsigned char *>(input.data()), input.size(),
+         digest);
+    return base64(digest, sizeof(digest));
+  }
+
+  size_t messagesReceived() const { return messageCount; }
+  size_t tradesReceived() const { return tradeCount; }
+
+private:
+  enum Opcode : unsigned char {
+    OpContinuation = 0x0,
+    OpText = 0x1,
+    OpBinary = 0x2,
+    OpClose = 0x8,
+    OpPing = 0x9,
+    OpPong = 0xa,
+  };
+
+  // Largest frame or reassembled message accepted; the feed's messages are
+  // a few hundred bytes, and anything near this means a broken stream.
+  static constexpr uint64_t MaxMessage = 16 << 20;
+
+  // Reads whatever the socket has and dispatches every complete message.
+  // Returns false when the connection is gone.
+  template <typename OnTrade> bool drain(OnTrade &onTrade) {
+    while (curl) {
+      size_t received = 0;
+      CURLcode res = curl_easy_recv(curl, buffer, sizeof(buffer), &received);
+      if (res == CURLE_AGAIN) {
+        return true;
+      }
+      if (res != CURLE_OK || received == 0) {
+        if (res != CURLE_OK) {
+          std::cerr << "Feed receive failed: " << curl_easy_strerror(res)
+                    << std::endl;
+        }
+        disconnect();
+        return false;
+      }
+      input.append(buffer, received);
+      if (!dispatch(onTrade)) {
+        disconnect();
+        return false;
+      }
+    }
+    return false;
+  }
+
+  // Consumes the complete frames at the front of `input`.
+  template <typename OnTrade> bool dispatch(OnTrade &onTrade) {
+    size_t offset = 0;
+    for (;;) {
+      const unsigned char *p =
+          reinterpret_cast<const unsigned char *>(input.data()) + offset;
+      const size_t available = input.size() - offset;
+      if (available < 2) {
+        break;
+      }
+      const bool fin = p[0] & 0x80;
+      const unsigned char opcode = p[0] & 0x0f;
+      const bool masked = p[1] & 0x80;
+      uint64_t length = p[1] & 0x7f;
+      size_t header = 2;
+      if (length == 126 || length == 127) {
+        const size_t extra = length == 126 ? 2 : 8;
+        if (available < header + extra) {
+          break;
+        }
+        length = 0;
+        for (size_t i = 0; i < extra; ++i) {
+          length = length << 8 | p[header + i];
+        }
+        header += extra;
+      }
+      if (masked) {
+        // Servers must not mask (RFC 6455 5.1); fail the connection.
+        std::cerr << "Feed: masked frame from server" << std::endl;
+        closeWith(1002);
+        return false;
+      }
+      if (length > MaxMessage || message.size() + length > MaxMessage) {
+        std::cerr << "Feed: frame of " << length << " bytes rejected"
+                  << std::endl;
+        closeWith(1009);
+        return false;
+      }
+      if (length > available - header) {
+        break; // wait for the rest of the frame
+      }
+      const char *payload = input.data() + offset + header;
+      offset += header + length;
+
+      switch (opcode) {
+      case OpPing:
+        sendFrame(OpPong, payload, length);
+        continue;
+      case OpPong:
+        continue;
+      case OpClose:
+        sendFrame(OpClose, payload, std::min<uint64_t>(length, 2));
+        return false;
+      default:
+        break;
+      }
+
+      message.append(payload, length);
+      if (!fin) {
+        continue; // fragmented message
+      }
+      ++messageCount;
+      Trade trade;
+      if (parseTrade(message.data(), message.size(), trade)) {
+        ++tradeCount;
+        onTrade(trade);
+      }
+      message.clear();
+    }
+    input.erase(0, offset);
+    return true;
+  }
+
+  // Sends a close frame with `code` before the caller drops the connection.
+  void closeWith(uint16_t code) {
+    const char payload[2] = {static_cast<char>(code >> 8),
+                             static_cast<char>(code & 0xff)};
+    sendFrame(OpClose, payload, sizeof(payload));
+  }
+
+  // Client frames are always masked (RFC 6455 5.3).
+  bool sendFrame(unsigned char opcode, const char *data, size_t size) {
+    if (!curl) {
+      return false;
+    }
+    frame.clear();
+    frame += static_cast<char>(0x80 | opcode);
+    if (size < 126) {
+      frame += static_cast<char>(0x80 | size);
+    } else if (size <= 0xffff) {
+      frame += static_cast<char>(0x80 | 126);
+      frame += static_cast<char>(size >> 8);
+      frame += static_cast<char>(size & 0xff);
+    } else {
+      frame += static_cast<char>(0x80 | 127);
+      for (int shift = 56; shift >= 0; shift -= 8) {
+        frame += static_cast<char>((static_cast<uint64_t>(size) >> shift) &
+                                   0xff);
+      }
+    }
+    const uint32_t key = static_cast<uint32_t>(maskRng());
+    char mask[4];
+    std::memcpy(mask, &key, sizeof(mask));
+    frame.append(mask, sizeof(mask));
+    for (size_t i = 0; i < size; ++i) {
+      frame += static_cast<char>(data[i] ^ mask[i % 4]);
+    }
+    return writeAll(frame.data(), frame.size());
+  }
+
+  bool writeAll(const char *data, size_t size) {
+    while (size > 0) {
+      size_t sent = 0;
+      CURLcode res = curl_easy_send(curl, data, size, &sent);
+      if (res == CURLE_AGAIN) {
+        pollfd fd{static_cast<int>(socket), POLLOUT, 0};
+        ::poll(&fd, 1, 1000);
+        continue;
+      }
+      if (res != CURLE_OK) {
+        std::cerr << "Feed send failed: " << curl_easy_strerror(res)
+                  << std::endl;
+        return false;
+      }
+      data += sent;
+      size -= sent;
+    }
+    return true;
+  }
+
+  // Reads the HTTP response to the upgrade request and checks that it
+  // answers `key`; frames that arrive in the same packet stay in `input`.
+  bool readUpgrade(const std::string &key) {
+    size_t end;
+    while ((end = input.find("\r\n\r\n")) == std::string::npos) {
+      size_t received = 0;
+      CURLcode res = curl_easy_recv(curl, buffer, sizeof(buffer), &received);
+      if (res == CURLE_AGAIN) {
+        pollfd fd{static_cast<int>(socket), POLLIN, 0};
+        if (::poll(&fd, 1, 10000) <= 0) {
+          std::cerr << "Feed: no upgrade response" << std::endl;
+          return false;
+        }
+        continue;
+      }
+      if (res != CURLE_OK || received == 0) {
+        std::cerr << "Feed: connection closed during upgrade" << std::endl;
+        return false;
+      }
+      input.append(buffer, received);
+    }
+    if (input.compare(0, 12, "HTTP/1.1 101") != 0) {
+      std::cerr << "Feed: upgrade refused: "
+                << input.substr(0, input.find("\r\n")) << std::endl;
+      return false;
+    }
+    if (headerValue(std::string_view(input).substr(0, end),
+                    "sec-websocket-accept") != acceptFor(key)) {
+      std::cerr << "Feed: upgrade response has a wrong Sec-WebSocket-Accept"
+                << std::endl;
+      return false;
+    }
+    input.erase(0, end + 4);
+    return true;
+  }
+
+  // Value of header `name` (lower case) in `head`, trimmed; empty if absent.
+  static std::string_view headerValue(std::string_view head,
+                                      std::string_view name) {
+    size_t line = head.find("\r\n");
+    while (line != std::string_view::npos) {
+      line += 2;
+      size_t next = head.find("\r\n", line);
+      std::string_view text = head.substr(
+          line, next == std::string_view::npos ? next : next - line);
+      size_t colon = text.find(':');
+      if (colon == name.size() &&
+          std::equal(name.begin(), name.end(), text.begin(),
+                     [](char a, char b) {
+                       return a == (b >= 'A' && b <= 'Z' ? b - 'A' + 'a' : b);
+                     })) {
+        text.remove_prefix(colon + 1);
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+          text.remove_prefix(1);
+        }
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+          text.remove_suffix(1);
+        }
+        return text;
+      }
+      line = next;
+    }
+    return {};
+  }
+
+  static uint32_t rotl(uint32_t value, int bits) {
+    return value << bits | value >> (32 - bits);
+  }
+
+  // SHA-1 (FIPS 180-4); only used for the handshake check, never for
+  // anything security relevant.
+  static void sha1(const unsigned char *data, size_t size,
+                   unsigned char digest[20]) {
+    uint32_t h[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476,
+                     0xc3d2e1f0};
+    std::vector<unsigned char> padded(data, data + size);
+    padded.push_back(0x80);
+    while (padded.size() % 64 != 56) {
+      padded.push_back(0);
+    }
+    const uint64_t bits = static_cast<uint64_t>(size) * 8;
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      padded.push_back(static_cast<unsigned char>(bits >> shift));
+    }
+
+    for (size_t block = 0; block < padded.size(); block += 64) {
+      uint32_t w[80];
+      for (int i = 0; i < 16; ++i) {
+        const unsigned char *p = &padded[block + i * 4];
+        w[i] = uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 |
+               uint32_t(p[2]) << 8 | p[3];
+      }
+      for (int i = 16; i < 80; ++i) {
+        w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+      }
+      uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+      for (int i = 0; i < 80; ++i) {
+        uint32_t f, k;
+        if (i < 20) {
+          f = (b & c) | (~b & d);
+          k = 0x5a827999;
+        } else if (i < 40) {
+          f = b ^ c ^ d;
+          k = 0x6ed9eba1;
+        } else if (i < 60) {
+          f = (b & c) | (b & d) | (c & d);
+          k = 0x8f1bbcdc;
+        } else {
+          f = b ^ c ^ d;
+          k = 0xca62c1d6;
+        }
+        const uint32_t t = rotl(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rotl(b, 30);
+        b = a;
+        a = t;
+      }
+      h[0] += a;
+      h[1] += b;
+      h[2] += c;
+      h[3] += d;
+      h[4] += e;
+    }
+    for (int i = 0; i < 5; ++i) {
+      for (int j = 0; j < 4; ++j) {
+        digest[i * 4 + j] = static_cast<unsigned char>(h[i] >> (24 - j * 8));
+      }
+    }
+  }
+
+  static std::string base64(const unsigned char *data, size_t size) {
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (size_t i = 0; i < size; i += 3) {
+      uint32_t chunk = uint32_t(data[i]) << 16;
+      if (i + 1 < size) {
+        chunk |= uint32_t(data[i + 1]) << 8;
+      }
+      if (i + 2 < size) {
+        chunk |= data[i + 2];
+      }
+      out += alphabet[chunk >> 18 & 63];
+      out += alphabet[chunk >> 12 & 63];
+      out += i + 1 < size ? alphabet[chunk >> 6 & 63] : '=';
+      out += i + 2 < size ? alphabet[chunk & 63] : '=';
+    }
+    return out;
+  }
+
+  // ws://host[:port]/path -> host header, request target and the http(s)
+  // URL curl connects to.
+  bool splitUrl(std::string &host, std::string &target,
+                std::string &httpUrl) const {
+    std::string rest;
+    if (url.compare(0, 6, "wss://") == 0) {
+      rest = url.substr(6);
+      httpUrl = "https://";
+    } else if (url.compare(0, 5, "ws://") == 0) {
+      rest = url.substr(5);
+      httpUrl = "http://";
+    } else {
+      return false;
+    }
+    size_t slash = rest.find('/');
+    host = rest.substr(0, slash);
+    target = slash == std::string::npos ? "/" : rest.substr(slash);
+    httpUrl += rest;
+    return !host.empty();
+  }
+
+  std::string handshakeKey() {
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    // 16 random bytes, base64: 21 full characters, one of 2 bits, "==".
+    std::string key;
+    for (int i = 0; i < 21; ++i) {
+      key += alphabet[maskRng() % 64];
+    }
+    key += alphabet[(maskRng() % 4) << 4];
+    key += "==";
+    return key;
+  }
+
+  // Value of a string field ("key":"value"); empty when absent.
+  static std::string_view field(std::string_view msg, std::string_view key) {
+    size_t at = find(msg, key);
+    if (at == std::string_view::npos || at >= msg.size() || msg[at] != '"') {
+      return {};
+    }
+    size_t end = msg.find('"', at + 1);
+    if (end == std::string_view::npos) {
+      return {};
+    }
+    return msg.substr(at + 1, end - at - 1);
+  }
+
+  // Raw text of a numeric field ("key":123); empty when absent.
+  static std::string_view number(std::string_view msg, std::string_view key) {
+    size_t at = find(msg, key);
+    if (at == std::string_view::npos) {
+      return {};
+    }
+    size_t end = msg.find_first_of(",}", at);
+    return msg.substr(at, end == std::string_view::npos ? end : end - at);
+  }
+
+  // Offset just past `"key":`, skipping spaces.
+  static size_t find(std::string_view msg, std::string_view key) {
+    size_t at = 0;
+    while ((at = msg.find(key, at)) != std::string_view::npos) {
+      size_t after = at + key.size();
+      if (at > 0 && msg[at - 1] == '"' && after < msg.size() &&
+          msg[after] == '"') {
+        after = msg.find_first_not_of(' ', after + 1);
+        if (after != std::string_view::npos && msg[after] == ':') {
+          return msg.find_first_not_of(' ', after + 1);
+        }
+      }
+      at = after;
+    }
+    return std::string_view::npos;
+  }
+
+  static bool parseDouble(std::string_view text, double &value) {
+    if (text.empty()) {
+      return false;
+    }
+    auto parsed = std::from_chars(text.data(), text.data() + text.size(),
+                                  value);
+    return parsed.ec == std::errc();
+  }
+
+  static bool digits(std::string_view text, size_t at, size_t count,
+                     int &value) {
+    value = 0;
+    for (size_t i = at; i < at + count; ++i) {
+      if (text[i] < '0' || text[i] > '9') {
+        return false;
+      }
+      value = value * 10 + (text[i] - '0');
+    }
+    return true;
+  }
+
+  // Days since 1970-01-01 for a proleptic Gregorian date.
+  static int64_t daysFromCivil(int64_t y, int m, int d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const int64_t yoe = y - era * 400;
+    const int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+  }
+
+  std::string url;
+  CURL *curl = nullptr;
+  curl_socket_t socket = CURL_SOCKET_BAD;
+  // Frame masks and the handshake key.
+  std::mt19937 maskRng{std::random_device{}()};
+  char buffer[16384];
+  std::string input;   // received bytes not yet parsed into frames
+  std::string message; // reassembles fragmented messages
+  std::string frame;   // outgoing frame, reused
+  size_t messageCount = 0;
+  size_t tradeCount = 0;
+};
+
+#endif // COINBASE_FEED_H
@@ -0,0 +1,294 @@
+// Headless signal daemon: the fetch -> indicators -> signal -> persist
+// pipeline without a window or raylib. Build with build.sh.
+//
+//   ./trading_daemon [product] [granularity] [cache_dir] [output_file]
+//                    [feed_url|none]
+//
+// The process sleeps until just after each candle closes (see
+// CandleScheduler), fetches the closed candles, appends them to the candle
+// store, runs them through the strategy engine and appends one analysis line
+// per candle to output_file (default analysis.txt). A failed fetch is retried
+// with backoff and missed candles are caught up. Between candles it reads
+// trades from the WebSocket feed (default wss://ws-feed.exchange.coinbase.com,
+// "none" to disable), builds the open candle from them and previews the
+// signal tick by tick; a change of the previewed signal is printed. Closed
+// candles still come from the REST windows. SIGINT/SIGTERM stop it at once.
+
+#include "backfill.h"
+#include "candle_aggregator.h"
+#include "candle_series.h"
+#include "candle_store.h"
+#include "coinbase.h"
+#include "coinbase_feed.h"
+#include "operations.h"
+#include "result_writer.h"
+#include "scheduler.h"
+#include "strategy.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <pthread.h>
+#include <string>
+#include <thread>
+
+class Daemon {
+public:
+  Daemon(const std::string &product_id, int granularity,
+         const std::string &cache_dir, const std::string &output_file,
+         const std::string &feed_url)
+      : productId(product_id), granularity(granularity),
+        writer(output_file), aggregator(granularity) {
+    if (feed_url != "none") {
+      feed = std::make_unique<CoinbaseFeed>(feed_url);
+    }
+    strategies.add(std::make_unique<MacdRsiKamaStrategy>());
+    try {
+      store = std::make_unique<CandleStore>(cache_dir, product_id,
+                                            granularity);
+    } catch (const std::exception &e) {
+      std::cerr << "Daemon: " << e.what() << std::endl;
+    }
+  }
+
+  // Runs until one of `stopSignals` arrives. They must already be blocked in
+  // every thread.
+  void run(const sigset_t &stopSignals) {
+    signals = &stopSignals;
+    CandleScheduler scheduler(granularity, warmUp());
+    // Candles that closed before startup only catch the indicators up.
+    reportFrom = scheduler.closedEnd();
+    for (;;) {
+      CandleScheduler::Window window = scheduler.due();
+      if (!window.empty() && !process(window, scheduler)) {
+        scheduler.failed();
+      }
+
+      int signal = stopSignal > 0 ? stopSignal
+                                  : wait(stopSignals, scheduler.nextWake());
+      if (signal > 0) {
+        std::cout << "Daemon: signal " << signal << ", stopping" << std::endl;
+        break;
+      }
+    }
+    writer.flush();
+  }
+
+private:
+  static constexpr std::time_t WarmUpSeconds = 24 * 60 * 60;
+  static constexpr auto FeedSlice = std::chrono::milliseconds(250);
+  static constexpr auto FeedRetry = std::chrono::seconds(30);
+  static constexpr long StopPollNanos = 100 * 1000 * 1000;
+
+  // Waits until `deadline` or a stop signal, whose number it returns. With
+  // the feed open the wait is spent reading trades, and stop signals are
+  // checked between short polls.
+  int wait(const sigset_t &stopSignals,
+           CandleScheduler::Clock::time_point deadline) {
+    for (;;) {
+      const auto now = CandleScheduler::Clock::now();
+      if (!feedOpen(now)) {
+        timespec timeout = until(deadline);
+        return sigtimedwait(&stopSignals, nullptr, &timeout);
+      }
+      const auto slice = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::min(deadline - now,
+                   CandleScheduler::Clock::duration(FeedSlice)));
+      const int timeoutMs =
+          static_cast<int>(std::max<long long>(0, slice.count()));
+      feed->poll(timeoutMs,
+                 [this](const CoinbaseFeed::Trade &trade) { onTrade(trade); });
+      timespec zero{0, 0};
+      int signal = sigtimedwait(&stopSignals, nullptr, &zero);
+      if (signal > 0 || CandleScheduler::Clock::now() >= deadline) {
+        return signal;
+      }
+    }
+  }
+
+  // Connects (or reconnects, at most every FeedRetry) and subscribes.
+  bool feedOpen(CandleScheduler::Clock::time_point now) {
+    if (!feed || feed->connected()) {
+      return feed != nullptr;
+    }
+    if (now < nextFeedAttempt) {
+      return false;
+    }
+    nextFeedAttempt = now + FeedRetry;
+    if (!feed->connect() || !feed->subscribe({productId})) {
+      std::cerr << "Daemon: feed unavailable, retrying later" << std::endl;
+      feed->disconnect();
+      return false;
+    }
+    std::cout << "Daemon: feed connected" << std::endl;
+    return true;
+  }
+
+  // Folds the trade into the open candle and previews the signal as if it
+  // closed now. Candles the feed closes are not fed to the engine; the REST
+  // window for that bucket is the one that counts.
+  void onTrade(const CoinbaseFeed::Trade &trade) {
+    Candle closed;
+    aggregator.add(trade.timeMicros, trade.price, trade.size, closed);
+    const IndicatorEngine &engine = strategies.indicators();
+    if (!aggregator.hasOpen() || !strategies.ready() ||
+        aggregator.current().timestamp <= engine.lastCandleTime()) {
+      return;
+    }
+    const Signal signal = strategies.preview(aggregator.current())[0];
+    if (signal == tickSignal) {
+      return;
+    }
+    tickSignal = signal;
+    char time[TimestampFormat::Length];
+    const size_t n = TimestampFormat::format(
+        static_cast<std::time_t>(trade.timeMicros / 1000000), time,
+        sizeof(time));
+    std::cout << "Tick ";
+    std::cout.write(time, static_cast<std::streamsize>(n));
+    std::cout << "\t Price: " << trade.price << "\t preview "
+              << signalName(signal) << std::endl;
+  }
+
+  static timespec until(CandleScheduler::Clock::time_point deadline) {
+    auto wait = std::max(deadline - CandleScheduler::Clock::now(),
+                         CandleScheduler::Clock::duration::zero());
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(wait);
+    auto nanoseconds =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(wait - seconds);
+    return {static_cast<std::time_t>(seconds.count()),
+            static_cast<long>(nanoseconds.count())};
+  }
+
+  // Primes the indicators from the cached history so the first live candle
+  // is judged on warm values. Returns the first bucket still to fetch.
+  std::time_t warmUp() {
+    std::time_t now = std::time(nullptr);
+    const std::time_t historyStart = now - now % granularity - WarmUpSeconds;
+    CandleSeries history;
+    if (store && !store->empty()) {
+      store->range(historyStart, now, history);
+    }
+    for (size_t i = 0; i < history.size(); ++i) {
+      strategies.update(history.at(i));
+    }
+    std::cout << "Daemon: " << history.size() << " cached candles" << std::endl;
+
+    // Whatever the cache lacks arrives as the scheduler's first window. It
+    // starts where the cache's coverage ends, even before historyStart, so
+    // the store never gets a hole.
+    return store && store->coveredEnd() != 0 ? store->coveredEnd()
+                                              : historyStart;
+  }
+
+  // Fetches the closed buckets in `window` and pushes them through the
+  // pipeline. On failure nothing is consumed and the window is retried;
+  // buckets not published yet stay due (see CandleScheduler::fetched).
+  // A catch-up window can span days of chunks and retry pauses, so a
+  // watcher collects stop signals meanwhile and stops the backfill; the
+  // signal is kept in stopSignal for run().
+  bool process(const CandleScheduler::Window &window,
+               CandleScheduler &scheduler) {
+    CandleSeries candles;
+    std::atomic<bool> running{true};
+    std::atomic<bool> fetching{true};
+    std::thread watcher([this, &running, &fetching] {
+      while (fetching.load()) {
+        timespec timeout{0, StopPollNanos};
+        int signal = sigtimedwait(signals, nullptr, &timeout);
+        if (signal > 0) {
+          stopSignal = signal;
+          running.store(false);
+          return;
+        }
+      }
+    });
+    Backfill::Options options;
+    options.running = &running;
+    Backfill backfill(coinbase, options);
+    const bool fetched = backfill.fetch(productId, granularity, window.start,
+                                        window.end, candles);
+    fetching.store(false);
+    watcher.join();
+    if (!fetched) {
+      if (stopSignal == 0) {
+        std::cerr << "Daemon: fetch failed, backing off" << std::endl;
+      }
+      return false;
+    }
+
+    scheduler.fetched(window, candles.empty() ? 0 : candles.time().back());
+    if (store) {
+      try {
+        store->append(candles, window.start,
+                      std::min(window.end, scheduler.processedUpTo()));
+      } catch (const std::exception &e) {
+        std::cerr << "Daemon: " << e.what() << std::endl;
+      }
+    }
+
+    for (size_t i = 0; i < candles.size(); ++i) {
+      const Candle candle = candles.at(i);
+      strategies.update(candle);
+      if (candle.timestamp < reportFrom || !strategies.ready()) {
+        continue;
+      }
+      Result res = strategies.result(candle);
+      writer.write(res);
+      char line[512];
+      size_t n = Operations::formatResult(res, line, sizeof(line));
+      std::cout.write(line, static_cast<std::streamsize>(n)) << std::endl;
+    }
+    return true;
+  }
+
+  std::string productId;
+  int granularity;
+  Coinbase coinbase;
+  StrategyEngine strategies;
+  std::unique_ptr<CandleStore> store;
+  ResultWriter writer;
+  std::time_t reportFrom = 0;
+  const sigset_t *signals = nullptr;
+  int stopSignal = 0; // set by process()'s watcher; read after the join
+  std::unique_ptr<CoinbaseFeed> feed;
+  CandleAggregator aggregator;
+  Signal tickSignal = Signal::Hold;
+  CandleScheduler::Clock::time_point nextFeedAttempt;
+};
+
+int main(int argc, char **argv) {
+  const std::string productId = argc > 1 ? argv[1] : "BTC-USD";
+  const int granularity = argc > 2 ? std::atoi(argv[2]) : 60;
+  const std::string cacheDir = argc > 3 ? argv[3] : "cache";
+  const std::string outputFile = argc > 4 ? argv[4] : "analysis.txt";
+  const std::string feedUrl =
+      argc > 5 ? argv[5] : "wss://ws-feed.exchange.coinbase.com";
+  if (granularity <= 0) {
+    std::cerr << "usage: trading_daemon [product] [granularity] [cache_dir] "
+                 "[output_file] [feed_url|none]"
+              << std::endl;
+    return 1;
+  }
+
+  // Block the stop signals before any thread starts so only the
+  // Daemon's sigtimedwait calls ever see them.
+  sigset_t stopSignals;
+  sigemptyset(&stopSignals);
+  sigaddset(&stopSignals, SIGINT);
+  sigaddset(&stopSignals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+  try {
+    Daemon daemon(productId, granularity, cacheDir, outputFile, feedUrl);
+    daemon.run(stopSignals);
+  } catch (const std::exception &e) {
+    std::cerr << "Daemon: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,323 @@
+#ifndef FETCH_WORKER_H
+#define FETCH_WORKER_H
+
+#include "backfill.h"
+#include "candle_store.h"
+#include "coinbase.h"
+#include "operations.h"
+#include "resampler.h"
+#include "scheduler.h"
+#include "spsc_queue.h"
+#include "strategy.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Fetches closed candles on a background thread just after each candle
+// boundary, streams them through the indicator engine, derives the signal
+// there, and hands finished snapshots to the render loop through a lock-free
+// queue. The render loop never blocks on the network. The same candles are
+// resampled into the higher timeframes, so those cost no extra requests.
+class FetchWorker {
+public:
+  struct Snapshot {
+    // One result per base candle this batch closed, oldest first; empty
+    // while the indicators warm up or when every candle was already seen.
+    std::vector<Result> results;
+    // Higher-timeframe bars closed by this batch, oldest first.
+    struct Bar {
+      int granularity;
+      Result result;
+    };
+    std::vector<Bar> bars;
+  };
+
+  // Live candles start at `start`; the first window covers [start, now) and
+  // later ones each newly closed bucket. When history_start is set,
+  // [history_start, start) is loaded first so the indicators are warm before
+  // the first live window. With a cache_dir the history comes from the
+  // on-disk candle store and only the gap after its tail is fetched; live
+  // candles are appended to it as they arrive.
+  FetchWorker(const std::string &product_id, int granularity, time_t start,
+              time_t history_start = 0, const std::string &cache_dir = "",
+              const CandleScheduler::Options &schedule = {})
+      : productId(product_id), granularity(granularity), windowStart(start),
+        historyStart(history_start), scheduler(granularity, start, schedule),
+        resampler(granularity, Resampler::defaultTimeframes(granularity)) {
+    strategies.add(std::make_unique<MacdRsiKamaStrategy>());
+    if (!cache_dir.empty()) {
+      try {
+        store = std::make_unique<CandleStore>(cache_dir, product_id,
+                                              granularity);
+      } catch (const std::exception &e) {
+        std::cerr << "Fetch worker: " << e.what() << std::endl;
+      }
+    }
+  }
+
+  ~FetchWorker() { stop(); }
+
+  FetchWorker(const FetchWorker &) = delete;
+  FetchWorker &operator=(const FetchWorker &) = delete;
+
+  void start() {
+    if (running.exchange(true)) {
+      return;
+    }
+    thread = std::thread(&FetchWorker::run, this);
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(wakeMutex);
+      if (!running.exchange(false)) {
+        return;
+      }
+    }
+    wake.notify_all();
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+
+  // Called from the render loop; never blocks.
+  bool poll(Snapshot &snapshot) { return snapshots.pop(snapshot); }
+
+  // Granularities of Snapshot::bars, besides the base one.
+  const std::vector<int> &timeframes() const { return resampler.timeframes(); }
+
+private:
+  void warmUp() {
+    CandleSeries history;
+    time_t gapStart = historyStart;
+    if (store && !store->empty() && store->firstTime() <= historyStart &&
+        store->coveredEnd() > historyStart) {
+      store->range(historyStart, windowStart, history);
+      gapStart = store->coveredEnd();
+    }
+    const size_t cached = history.size();
+
+    if (gapStart < windowStart) {
+      Backfill backfill(coinbase, backfillOptions());
+      const bool complete = backfill.fetch(productId, granularity, gapStart,
+                                           windowStart, history);
+      if (!running.load()) {
+        return;
+      }
+      if (!complete) {
+        std::cerr << "Fetch worker: history backfill incomplete" << std::endl;
+      } else if (store) {
+        persist(history, gapStart, windowStart);
+      }
+    }
+
+    seedTimeframes();
+    if (!running.load()) {
+      return;
+    }
+    for (size_t i = 0; i < history.size(); ++i) {
+      strategies.update(history.at(i));
+      resampler.update(history.at(i));
+    }
+    std::cout << "History candles : " << history.size() << " (" << cached
+              << " cached)" << std::endl;
+  }
+
+  // Timeframes the base history holds fewer than SeedBars bars of (6h and
+  // 1d on a day of history) are fetched once at their own granularity,
+  // ending where the resampled bars take over, so their indicators are
+  // ready at startup rather than after days of uptime.
+  void seedTimeframes() {
+    for (int barGranularity : resampler.timeframes()) {
+      if ((windowStart - historyStart) / barGranularity >= SeedBars) {
+        continue;
+      }
+      const time_t offset = historyStart % barGranularity;
+      const time_t end =
+          offset == 0 ? historyStart : historyStart - offset + barGranularity;
+      CandleSeries bars;
+      Backfill backfill(coinbase, backfillOptions());
+      const time_t seedStart = end - SeedBars * barGranularity;
+      const bool fetched =
+          backfill.fetch(productId, barGranularity, seedStart, end, bars);
+      if (!running.load()) {
+        return;
+      }
+      if (!fetched) {
+        std::cerr << "Fetch worker: no seed bars for " << barGranularity
+                  << " s timeframe" << std::endl;
+        continue;
+      }
+      resampler.seed(barGranularity, bars, end);
+    }
+  }
+
+  // Backfills started by the worker give up between chunks once stop() is
+  // called.
+  Backfill::Options backfillOptions() const {
+    Backfill::Options options;
+    options.running = &running;
+    return options;
+  }
+
+  // Caches the fetched window [from, to). If an earlier window never reached
+  // the store (a failed or partial fetch), the missing stretch is fetched
+  // first so the store never has a hole.
+  void persist(const CandleSeries &candles, time_t from, time_t to) {
+    try {
+      const time_t covered = store->coveredEnd();
+      if (covered != 0 && covered < from) {
+        CandleSeries gap;
+        Backfill backfill(coinbase, backfillOptions());
+        if (!backfill.fetch(productId, granularity, covered, from, gap)) {
+          std::cerr << "Fetch worker: cache gap not filled yet" << std::endl;
+          return;
+        }
+        store->append(gap, covered, from);
+      }
+      store->append(candles, from, to);
+    } catch (const std::exception &e) {
+      std::cerr << "Fetch worker: " << e.what() << std::endl;
+    }
+  }
+
+  void run() {
+    if (historyStart > 0 && historyStart < windowStart) {
+      warmUp();
+    }
+
+    while (running.load()) {
+      CandleScheduler::Window window = scheduler.due();
+      if (!window.empty() && !fetchWindow(window)) {
+        scheduler.failed();
+      }
+
+      // A batch the render loop has no room for yet is offered again soon,
+      // before the next window.
+      CandleScheduler::Clock::time_point wakeAt = scheduler.nextWake();
+      if (!retryPublish()) {
+        wakeAt =
+            std::min(wakeAt, CandleScheduler::Clock::now() + PublishRetry);
+      }
+      std::unique_lock<std::mutex> lock(wakeMutex);
+      wake.wait_until(lock, wakeAt, [this] { return !running.load(); });
+    }
+  }
+
+  // Fetches the closed buckets in `window` and publishes a snapshot with a
+  // result for each of them. On failure nothing is consumed, so the scheduler's retry
+  // fetches the whole window again. Trailing buckets the exchange has not
+  // published yet stay due (see CandleScheduler::fetched) and are neither
+  // cached nor fed until they arrive.
+  bool fetchWindow(const CandleScheduler::Window &window) {
+    // Formatted on this thread into stack buffers; see timestamp_format.h.
+    char startText[TimestampFormat::Length + 1];
+    char endText[TimestampFormat::Length + 1];
+    startText[TimestampFormat::format(window.start, startText,
+                                      TimestampFormat::Length)] = '\0';
+    endText[TimestampFormat::format(window.end, endText,
+                                    TimestampFormat::Length)] = '\0';
+    std::cout << "Fetching data.... " << std::endl;
+    std::cout << "start time  : " << window.start << "   " << startText
+              << std::endl;
+    std::cout << "end time  : " << window.end << "   " << endText << std::endl;
+
+    CandleSeries series;
+    Backfill backfill(coinbase, backfillOptions());
+    if (!backfill.fetch(productId, granularity, window.start, window.end,
+                        series)) {
+      std::cerr << "Fetch worker: window fetch failed, backing off"
+                << std::endl;
+      return false;
+    }
+    std::cout << "Candles size : " << series.size() << std::endl;
+    scheduler.fetched(window, series.empty() ? 0 : series.time().back());
+    if (store) {
+      persist(series, window.start,
+              std::min(window.end, scheduler.processedUpTo()));
+    }
+    if (series.empty()) {
+      return true; // no trades in these buckets, or not published yet
+    }
+
+    // Only candles the engine has not seen yet are fed.
+    Snapshot snapshot;
+    for (size_t i = 0; i < series.size(); ++i) {
+      const Candle candle = series.at(i);
+      const IndicatorEngine &engine = strategies.indicators();
+      if (engine.size() == 0 || candle.timestamp > engine.lastCandleTime()) {
+        strategies.update(candle);
+        if (candle.timestamp > lastResultTime && strategies.ready()) {
+          snapshot.results.push_back(strategies.result(candle));
+          lastResultTime = candle.timestamp;
+        }
+        resampler.update(candle, [&](int barGranularity, const Candle &bar,
+                                     const IndicatorEngine &indicators) {
+          if (indicators.ready()) {
+            snapshot.bars.push_back(
+                {barGranularity, StrategyEngine::result(
+                                     indicators, strategies.strategy(0), bar)});
+          }
+        });
+      }
+    }
+
+    publish(std::move(snapshot));
+    return true;
+  }
+
+  // Hands `snapshot` to the render loop. Its candles are already consumed,
+  // so while the queue is full it is kept, merged with later batches and
+  // offered again by run() rather than dropped.
+  void publish(Snapshot &&snapshot) {
+    if (!hasUnpublished) {
+      unpublished = std::move(snapshot);
+      hasUnpublished = true;
+    } else {
+      unpublished.results.insert(unpublished.results.end(),
+                                 snapshot.results.begin(),
+                                 snapshot.results.end());
+      unpublished.bars.insert(unpublished.bars.end(), snapshot.bars.begin(),
+                              snapshot.bars.end());
+    }
+    retryPublish();
+  }
+
+  bool retryPublish() {
+    if (hasUnpublished && snapshots.push(std::move(unpublished))) {
+      unpublished = Snapshot{};
+      hasUnpublished = false;
+    }
+    return !hasUnpublished;
+  }
+
+  static constexpr time_t SeedBars = 100;
+  static constexpr auto PublishRetry = std::chrono::milliseconds(100);
+
+  Coinbase coinbase;
+  StrategyEngine strategies;
+  std::string productId;
+  int granularity;
+  time_t windowStart;
+  time_t historyStart;
+  CandleScheduler scheduler;
+  Resampler resampler;
+  time_t lastResultTime = 0;
+  std::unique_ptr<CandleStore> store;
+
+  SpscQueue<Snapshot, 64> snapshots;
+  Snapshot unpublished; // worker thread only
+  bool hasUnpublished = false;
+  std::atomic<bool> running{false};
+  std::mutex wakeMutex;
+  std::condition_variable wake;
+  std::thread thread;
+};
+
+#endif // FETCH_WORKER_H
@@ -0,0 +1,108 @@
+#ifndef FIXED_PRICE_H
+#define FIXED_PRICE_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Whole number of a product's quote increment (1 tick = 0.01 USD on
+// BTC-USD). Sums, differences and comparisons of ticks are exact and give
+// the same result on every machine, unlike the doubles the indicators work
+// in.
+using Ticks = int64_t;
+
+// A product's quote increment, `units` x 10^-decimals (Coinbase's
+// "quote_increment", e.g. "0.01" or "0.00001"), and the conversion between
+// ticks and double prices at the indicator boundary. A default-constructed
+// increment is disabled: callers keep working in doubles.
+class QuoteIncrement {
+public:
+  QuoteIncrement() = default;
+  QuoteIncrement(int64_t units, int decimals)
+      : units(units > 0 ? units : 0), decimals(decimals),
+        scale(powerOfTen(decimals)) {}
+
+  // Parses a decimal string such as "0.01"; false if it is not a positive
+  // increment with at most 15 decimals.
+  static bool parse(std::string_view text, QuoteIncrement &out) {
+    int64_t digits = 0;
+    int fraction = -1;
+    for (char c : text) {
+      if (c == '.' && fraction < 0) {
+        fraction = 0;
+      } else if (c >= '0' && c <= '9' && digits < 100000000000000LL) {
+        digits = digits * 10 + (c - '0');
+        fraction += fraction >= 0;
+      } else {
+        return false;
+      }
+    }
+    fraction = fraction < 0 ? 0 : fraction;
+    if (digits <= 0 || fraction > 15) {
+      return false;
+    }
+    out = QuoteIncrement(digits, fraction);
+    return true;
+  }
+
+  bool enabled() const { return units > 0; }
+
+  // Nearest tick; halfway cases round away from zero.
+  Ticks toTicks(double price) const {
+    return static_cast<Ticks>(std::llround(price * scale / units));
+  }
+
+  double toDouble(Ticks ticks) const {
+    return static_cast<double>(ticks * units) / scale;
+  }
+
+  // Exact decimal text of `ticks`, with the increment's decimals; returns
+  // the length written (truncated to fit).
+  size_t format(Ticks ticks, char *out, size_t size) const {
+    char digits[32];
+    uint64_t value = ticks < 0 ? 0 - static_cast<uint64_t>(ticks)
+                               : static_cast<uint64_t>(ticks);
+    value *= static_cast<uint64_t>(units);
+    size_t n = 0;
+    do {
+      digits[n++] = static_cast<char>('0' + value % 10);
+      value /= 10;
+    } while (value > 0 || n <= static_cast<size_t>(decimals));
+
+    size_t length = 0;
+    auto put = [&](char c) {
+      if (length < size) {
+        out[length++] = c;
+      }
+    };
+    if (ticks < 0) {
+      put('-');
+    }
+    while (n > 0) {
+      if (n == static_cast<size_t>(decimals)) {
+        put('.');
+      }
+      put(digits[--n]);
+    }
+    return length;
+  }
+
+  int64_t incrementUnits() const { return units; }
+  int incrementDecimals() const { return decimals; }
+
+private:
+  static double powerOfTen(int exponent) {
+    double value = 1.0;
+    for (int i = 0; i < exponent; ++i) {
+      value *= 10.0;
+    }
+    return value;
+  }
+
+  int64_t units = 0;
+  int decimals = 0;
+  double scale = 1.0; // 10^decimals, exact up to 10^22
+};
+
+#endif // FIXED_PRICE_H
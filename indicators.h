@@ -0,0 +1,194 @@
+#ifndef INDICATORS_H
+#define INDICATORS_H
+
+#include "coinbase.h"
+#include "operations.h"
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Streaming counterparts of the batch functions in Operations. Each update()
+// costs constant time and never allocates; fed the same closes in the same
+// order, the values match Operations bit for bit.
+
+class EmaState {
+public:
+  explicit EmaState(int period = 12) : multiplier(2.0 / (period + 1)) {}
+
+  double update(double price) {
+    if (count == 0) {
+      ema = price; // Initial EMA value
+    } else {
+      ema = (price - ema) * multiplier + ema;
+    }
+    ++count;
+    return ema;
+  }
+
+  double value() const { return ema; }
+  size_t size() const { return count; }
+
+private:
+  double multiplier;
+  double ema = 0.0;
+  size_t count = 0;
+};
+
+class MacdState {
+public:
+  MacdState(int shortPeriod = 12, int longPeriod = 26, int signalPeriod = 9)
+      : shortEMA(shortPeriod), longEMA(longPeriod), signalEMA(signalPeriod) {}
+
+  const MACDResult &update(double price) {
+    double macdLine = shortEMA.update(price) - longEMA.update(price);
+    double signalLine = signalEMA.update(macdLine);
+    current = {macdLine, signalLine, macdLine - signalLine};
+    return current;
+  }
+
+  const MACDResult &value() const { return current; }
+  bool ready() const { return shortEMA.size() > 0; }
+
+private:
+  EmaState shortEMA;
+  EmaState longEMA;
+  EmaState signalEMA;
+  MACDResult current{0.0, 0.0, 0.0};
+};
+
+// Wilder-smoothed RSI. The first `period` changes are averaged, later ones
+// are smoothed exactly as Operations::calculateRSI does.
+class RsiState {
+public:
+  explicit RsiState(size_t period = 14) : period(period) {}
+
+  void update(double price) {
+    if (!hasPrevious) {
+      previous = price;
+      hasPrevious = true;
+      return;
+    }
+    double change = price - previous;
+    previous = price;
+    ++changes;
+
+    if (changes <= period) {
+      if (change > 0) {
+        gain += change;
+      } else {
+        loss -= change;
+      }
+      if (changes == period) {
+        gain /= period;
+        loss /= period;
+      }
+    } else if (change > 0) {
+      gain = (gain * (period - 1) + change) / period;
+      loss = (loss * (period - 1)) / period;
+    } else {
+      gain = (gain * (period - 1)) / period;
+      loss = (loss * (period - 1) - change) / period;
+    }
+  }
+
+  bool ready() const { return changes >= period; }
+
+  double value() const {
+    double rs = (loss == 0.0) ? 100.0 : gain / loss;
+    return 100.0 - (100.0 / (1.0 + rs));
+  }
+
+private:
+  size_t period;
+  double previous = 0.0;
+  bool hasPrevious = false;
+  size_t changes = 0;
+  double gain = 0.0;
+  double loss = 0.0;
+};
+
+// Streaming KAMA with a rolling volatility sum. Keeps the last period + 2
+// closes in a ring allocated once up front.
+class KamaState {
+public:
+  explicit KamaState(size_t period = 10)
+      : period(period), closes(period + 2) {}
+
+  void update(double price) {
+    if (count >= 1) {
+      double change = std::abs(price - close(count - 1));
+      if (count <= period) {
+        volatility += change;
+      } else {
+        volatility += change - std::abs(close(count - period) -
+                                        close(count - period - 1));
+      }
+    }
+
+    if (count + 1 == period) {
+      kama = price;
+    } else if (count >= period) {
+      double priceChange = std::abs(price - close(count - period));
+      kama += Operations::kamaSmoothingConstant(priceChange, volatility) *
+              (price - kama);
+    }
+
+    closes[count % closes.size()] = price;
+    ++count;
+  }
+
+  bool ready() const { return count >= period; }
+  double value() const { return kama; }
+
+private:
+  double close(size_t i) const { return closes[i % closes.size()]; }
+
+  size_t period;
+  std::vector<double> closes;
+  size_t count = 0;
+  double volatility = 0.0;
+  double kama = 0.0;
+};
+
+// Per-product indicator state: feed every closed candle once, oldest first.
+class IndicatorEngine {
+public:
+  struct Periods {
+    size_t kama = 10;
+    size_t rsi = 14;
+    int macdShort = 12;
+    int macdLong = 26;
+    int macdSignal = 9;
+  };
+
+  IndicatorEngine() : IndicatorEngine(Periods{}) {}
+  explicit IndicatorEngine(const Periods &periods)
+      : kamaState(periods.kama), rsiState(periods.rsi),
+        macdState(periods.macdShort, periods.macdLong, periods.macdSignal) {}
+
+  void update(const Coinbase::Candle &candle) {
+    kamaState.update(candle.closingPrice);
+    rsiState.update(candle.closingPrice);
+    macdState.update(candle.closingPrice);
+    lastTimestamp = candle.timestamp;
+    ++count;
+  }
+
+  bool ready() const { return kamaState.ready() && rsiState.ready(); }
+
+  double kama() const { return kamaState.value(); }
+  double rsi() const { return rsiState.value(); }
+  const MACDResult &macd() const { return macdState.value(); }
+
+  std::time_t lastCandleTime() const { return lastTimestamp; }
+  size_t size() const { return count; }
+
+private:
+  KamaState kamaState;
+  RsiState rsiState;
+  MacdState macdState;
+  std::time_t lastTimestamp = 0;
+  size_t count = 0;
+};
+
+#endif // INDICATORS_H
@@ -1,7 +1,15 @@
+#include "chart_renderer.h"
+#include "fetch_worker.h"
 #include "operations.h"
 #include "raylib.h"
+#include "result_history.h"
+#include "result_writer.h"
+#include "stats_panel.h"
 #include <algorithm>
+#include <cmath>
 #include <cstdio>
+#include <memory>
+#include <vector>
 
 void handleInput() { std::cout << "Inputs" << std::endl; }
 void handleKeyboard() {
@@ -30,10 +38,11 @@ void moveCamera(Camera2D &camera) {
     isDragging = false;
   }
 
+  // Zoom geometrically so a long history can be zoomed all the way out.
   if (GetMouseWheelMove() != 0) {
-    camera.zoom += GetMouseWheelMove() * 0.05f;
-    if (camera.zoom < 0.1f)
-      camera.zoom = 0.1f;
+    camera.zoom *= std::pow(1.1f, GetMouseWheelMove());
+    if (camera.zoom < 0.00001f)
+      camera.zoom = 0.00001f;
     if (camera.zoom > 3.0f)
       camera.zoom = 3.0f;
   }
@@ -41,21 +50,37 @@ void moveCamera(Camera2D &camera) {
 
 int main() {
 
-  std::unique_ptr<Coinbase> coinbase = std::make_unique<Coinbase>();
-  std::unique_ptr<Operations> operations = std::make_unique<Operations>();
-
   int granularity = 60;
   time_t start = std::time(nullptr) - (60 * 60); // 1 hour before
-  time_t end = start + (granularity * 60);       // now
+
+  // Warm the indicators up on a day of history before the first live window;
+  // history is cached under ./cache so restarts only fetch the missing tail.
+  FetchWorker worker("BTC-USD", granularity, start, start - (24 * 60 * 60),
+                     "cache");
 
   // Initialization
   //--------------------------------------------------------------------------------------
   int screenWidth = 1280;
   int screenHeight = 720;
-  float timer = 59.0f;
 
-  std::vector<Coinbase::Candle> candles;
-  std::vector<Result> result;
+  // One chart per timeframe: the fetched candles first, then the bars the
+  // worker resamples from them. Keys 1..9 switch between them. A day of
+  // results (at least 256) stays in memory per timeframe; older ones spill
+  // to disk segments, so a long session keeps flat memory.
+  std::vector<int> timeframes = {granularity};
+  for (int barGranularity : worker.timeframes()) {
+    timeframes.push_back(barGranularity);
+  }
+  std::vector<std::unique_ptr<ResultHistory>> results;
+  for (int g : timeframes) {
+    const size_t retention = std::max(24 * 60 * 60 / g, 256);
+    results.push_back(std::make_unique<ResultHistory>(
+        retention, "cache/results/" + std::to_string(g)));
+  }
+  std::vector<ChartRenderer> charts(timeframes.size());
+  ResultHistory &result = *results[0];
+  size_t shown = 0;
+  StatsPanel statsPanel;
   SetConfigFlags(FLAG_MSAA_4X_HINT);
   InitWindow(screenWidth, screenHeight, "Trading View");
 
@@ -68,17 +93,10 @@ int main() {
   camera.rotation = 0.0f;
   camera.zoom = 1.0f;
 
-  static int buy_count = 0;
-  static int sell_count = 0;
-  static int buy_success_count = 0;
-  static int buy_fail_count = 0;
-  static int sell_success_count = 0;
-  static int sell_fail_count = 0;
-  static float last_buy_price = 0.0f;
-  static float last_sell_price = 0.0f;
-  bool buy_flag = false;
-  bool sell_flag = false;
+  TradeTally tally(QuoteIncrement(1, 2)); // BTC-USD is quoted in cents
   bool first_flag = true;
+
+  worker.start();
   //--------------------------------------------------------------------------------------
 
   // Main loop
@@ -92,73 +110,37 @@ int main() {
     screenHeight = GetScreenHeight();
 
     moveCamera(camera);
+    for (size_t i = 0; i < timeframes.size() && i < 9; ++i) {
+      if (IsKeyPressed(KEY_ONE + static_cast<int>(i)) && i != shown) {
+        shown = i;
+        first_flag = true;
+      }
+    }
 
-    float deltaTime = GetFrameTime();
-    timer += deltaTime;
-
-    if (timer >= granularity) {
-      timer = 0.0f;
-      std::cout << "Fetching data.... " << std::endl;
-      candles = coinbase->fetchCoinbaseData("BTC-USD", granularity, start, end);
-
-      std::cout << "Candles size : " << candles.size() << std::endl;
-      std::cout << "start time  : " << std::to_string(start) << "   "
-                << operations->convertToTimestamp(start) << std::endl;
-      std::cout << "end time  : " << std::to_string(end) << "   "
-                << operations->convertToTimestamp(end) << std::endl;
-
-      if (!candles.empty()) {
-
-        std::reverse(candles.begin(), candles.end());
-
-        double kama = operations->calculateKAMA(candles, 10);
-        double rsi = operations->calculateRSI(candles, 14);
-        MACDResult macd = operations->calculateMACD(candles);
-
-        const Coinbase::Candle latestCandle = candles.back();
-        static std::time_t lastFetchTime;
-        if (lastFetchTime != latestCandle.timestamp) {
-
-          std::string signal;
-
-          if (macd.macdLine > macd.signalLine && rsi < 50 &&
-              latestCandle.closingPrice > kama) {
-            signal = "BUY";
-            last_buy_price = latestCandle.closingPrice;
-            buy_flag = true;
-            buy_count++;
-          } else if (macd.macdLine < macd.signalLine && rsi > 50 &&
-                     latestCandle.closingPrice < kama) {
-            signal = "SELL";
-            last_sell_price = latestCandle.closingPrice;
-            sell_flag = true;
-            sell_count++;
-          } else {
-            signal = "HOLD";
-          }
-
-          Result res;
-          res.timestamp = latestCandle.timestamp;
-          res.macd = macd;
-          res.price = latestCandle.closingPrice;
-          res.kama = kama;
-          res.rsi = rsi;
-          res.signal = signal;
-          res.normalized_timestamp = 60;
-
-          result.push_back(res);
+    // Drain whatever the fetch worker has finished; never blocks.
+    FetchWorker::Snapshot snapshot;
+    while (worker.poll(snapshot)) {
+      for (const auto &bar : snapshot.bars) {
+        size_t index = static_cast<size_t>(
+            std::find(timeframes.begin(), timeframes.end(), bar.granularity) -
+            timeframes.begin());
+        if (index < results.size()) {
+          results[index]->push(bar.result);
+        }
+      }
+      for (const Result &res : snapshot.results) {
+        tally.record(res);
 #if 0
-          operations->writeAnalysisToFile("analysis.txt",
-                                          operations->resultToString(res));
+        static ResultWriter analysisWriter("analysis.txt");
+        analysisWriter.write(res);
 #endif
-          lastFetchTime = latestCandle.timestamp;
-        }
+        result.push(res);
       }
+    }
 
-      start = start + granularity;
-      end = end + granularity;
-      // std::this_thread::sleep_for(std::chrono::seconds(granularity));
-      operations->normalizeData(result);
+    // The panel text is re-rendered off-screen only when it changes.
+    if (!result.empty()) {
+      statsPanel.update(tally.stats(), result.back(), screenWidth);
     }
 
     // Draw
@@ -167,113 +149,39 @@ int main() {
 
     ClearBackground(BLACK);
 
-    if (result.size() > 0) {
-      float x_scale = (screenWidth / static_cast<float>(result.size()));
-      float y_scale = (screenHeight / 2.0f);
-      Color color = RED;
-      int fontsize = 12;
-      static Vector2 prevPosition = {0.0f, 0.0f};
+    const ResultHistory &visible = *results[shown];
+    ChartRenderer &chart = charts[shown];
+    if (visible.size() > 0) {
+      if (first_flag) {
+        first_flag = false;
+        chart.sync(visible);
+        camera.target =
+            chart.pointPosition(0, visible.front().price, screenHeight);
+      }
 
       BeginMode2D(camera);
 
-      for (size_t i = 0; i < result.size(); i++) {
-
-        float x =
-            static_cast<float>(result.at(i).normalized_timestamp * (i + 2));
-        float y = static_cast<float>(screenHeight -
-                                     (result.at(i).normalized_price * y_scale));
-
-        if (prevPosition.x != x && prevPosition.y != y) {
-          if (i != 0) {
-            DrawLineBezier(prevPosition, (Vector2){x, y}, 0.7f, WHITE);
-          }
-          prevPosition = (Vector2){x, y};
-        }
-
-        if (result.at(i).signal == "HOLD")
-          color = RED; //{27, 38, 49, 255};
-        else if (result.at(i).signal == "BUY")
-          color = DARKGREEN;
-        else
-          color = DARKBLUE; //{244, 208, 63, 255};
-
-        if (buy_flag) {
-          if (sell_flag) {
-            buy_flag = false;
-            sell_flag = false;
-            if (last_sell_price - last_buy_price > 0)
-              buy_success_count++;
-            else
-              buy_fail_count++;
-          }
-        }
-
-        if (sell_flag) {
-          if (buy_flag) {
-            sell_flag = false;
-            buy_flag = false;
-            if (last_sell_price - last_buy_price > 0)
-              sell_success_count++;
-            else
-              sell_fail_count++;
-          }
-        }
-
-        DrawCircleV({x, y}, 3, RED);
-        DrawText(result.at(i).signal.c_str(), x + 3, y, fontsize, color);
-        DrawText(std::to_string(result.at(i).price).c_str(), x + 3, y + 16,
-                 fontsize, color);
-        if (first_flag) {
-          first_flag = false;
-          camera.target = {x, y};
-        }
-        // DrawText(std::to_string(result.at(i).normalized_price).c_str(), x +
-        // 3, y + 32, fontsize, color);
-        // DrawText(std::to_string(i).c_str(), x + 3, y + 47, fontsize, color);
-      }
+      chart.draw(visible, camera, screenWidth, screenHeight);
 
       EndMode2D();
-      DrawLineEx(
-          (Vector2){0.0f, screenHeight - 250.0f},
-          (Vector2){static_cast<float>(screenWidth), screenHeight - 250.0f},
-          4.0f, GRAY);
-      Color rectangleColor{33, 47, 61, 255};
-      DrawRectangle(0, screenHeight - 250, screenWidth, screenHeight - 250,
-                    rectangleColor);
-
-      char buffer[100];
-      Color textColor = GRAY;
-
-      sprintf(buffer, "Total buy decision : %d", buy_count);
-      DrawText(buffer, 50, screenHeight - 200, fontsize + 7, textColor);
-
-      sprintf(buffer, "Total sell decision : %d", sell_count);
-      DrawText(buffer, 50, screenHeight - 170, fontsize + 7, textColor);
-
-      sprintf(buffer, "Total successfull buy decision : %d", buy_success_count);
-      DrawText(buffer, 50, screenHeight - 140, fontsize + 7, textColor);
-
-      sprintf(buffer, "Total failed buy decision : %d", buy_fail_count);
-      DrawText(buffer, 50, screenHeight - 110, fontsize + 7, textColor);
-
-      sprintf(buffer, "Total successfull sell decision : %d",
-              sell_success_count);
-      DrawText(buffer, 50, screenHeight - 80, fontsize + 7, textColor);
-
-      sprintf(buffer, "Total failed sell decision : %d", sell_fail_count);
-      DrawText(buffer, 50, screenHeight - 50, fontsize + 7, textColor);
+    }
 
-      sprintf(buffer, "Last signal : %s - %s", result.back().signal.c_str(),
-              operations->convertToTimestamp(result.back().timestamp).c_str());
-      DrawText(buffer, screenWidth - 400, screenHeight - 200, fontsize + 7,
-               color);
+    if (result.size() > 0) {
+      statsPanel.draw(screenWidth, screenHeight);
     }
 
+    char timeframeLabel[32];
+    std::snprintf(timeframeLabel, sizeof(timeframeLabel), "[%zu] %d min",
+                  shown + 1, timeframes[shown] / 60);
+    DrawText(timeframeLabel, 10, 10, 20, GRAY);
+
     EndDrawing();
     //----------------------------------------------------------------------------------
   }
   // De-Initialization
   //--------------------------------------------------------------------------------------
+  worker.stop();
+  statsPanel.unload();
   CloseWindow(); // Close window and OpenGL context
   //--------------------------------------------------------------------------------------
 
@@ -2,14 +2,20 @@
 #define OPERATIONS_H
 
 #include "coinbase.h"
-#include "raylib.h"
+#include "timestamp_format.h"
 #include <algorithm>
+#include <charconv>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <string>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
 struct MACDResult {
@@ -18,6 +24,20 @@ struct MACDResult {
   double histogram;
 };
 
+enum class Signal : uint8_t { Hold, Buy, Sell };
+
+inline const char *signalName(Signal signal) {
+  switch (signal) {
+  case Signal::Buy:
+    return "BUY";
+  case Signal::Sell:
+    return "SELL";
+  default:
+    return "HOLD";
+  }
+}
+
+// Plain data so results can live in flat arrays or be written out verbatim.
 struct Result {
   time_t timestamp;
   MACDResult macd;
@@ -26,74 +46,108 @@ struct Result {
   double normalized_timestamp;
   double kama;
   double rsi;
-  std::string signal;
+  Signal signal;
 };
+static_assert(std::is_trivially_copyable<Result>::value,
+              "Result must stay trivially copyable");
 
 class Operations {
 public:
-  double calculateKAMA(const std::vector<Coinbase::Candle> &candles,
-                       size_t period = 10) {
-    if (candles.size() < period) {
-      throw std::invalid_argument("Not enough data to calculate KAMA.");
-    }
-
+  // Kaufman smoothing constant for one bar from the net price change over the
+  // period and the summed absolute bar-to-bar changes (the volatility).
+  static double kamaSmoothingConstant(double priceChange, double volatility) {
     const double fastestSC = 2.0 / (2 + 1);  // Fastest smoothing constant
     const double slowestSC = 2.0 / (30 + 1); // Slowest smoothing constant
 
-    double kama = candles[candles.size() - period].closingPrice;
+    // A rolling volatility can drift a few ulps, so keep the ratio in [0, 1].
+    double er =
+        (volatility > 0.0) ? std::min(priceChange / volatility, 1.0) : 0.0;
+    double sc = er * (fastestSC - slowestSC) + slowestSC;
+    return sc * sc;
+  }
 
-    for (size_t i = candles.size() - period + 1; i < candles.size(); ++i) {
-      double priceChange =
-          std::abs(candles[i].closingPrice - candles[i - period].closingPrice);
-      double volatility = 0.0;
-      for (size_t j = 0; j < period; ++j) {
-        volatility += std::abs(candles[i - j].closingPrice -
-                               candles[i - j - 1].closingPrice);
-      }
-      double er = (volatility == 0.0) ? 0.0 : priceChange / volatility;
-      double smoothingConstant =
-          std::pow(er * (fastestSC - slowestSC) + slowestSC, 2);
+  // KAMA seeded with the close at index period - 1. The volatility is kept as
+  // a rolling sum, so each bar costs O(1) regardless of the period.
+  double calculateKAMA(const std::vector<Coinbase::Candle> &candles,
+                       size_t period = 10) {
+    return kamaOver(
+        [&candles](size_t i) { return candles[i].closingPrice; },
+        candles.size(), period);
+  }
 
-      kama += smoothingConstant * (candles[i].closingPrice - kama);
-    }
+  double calculateKAMA(Span<double> closes, size_t period = 10) {
+    return kamaOver([closes](size_t i) { return closes[i]; }, closes.size(),
+                period);
+  }
 
-    return kama;
+  double calculateKAMA(const CandleSeries &series, size_t period = 10) {
+    return calculateKAMA(series.close(), period);
   }
 
-  double calculateRSI(const std::vector<Coinbase::Candle> &candles,
-                      size_t period = 14) {
-    if (candles.size() < period + 1) {
-      throw std::invalid_argument("Not enough data to calculate RSI.");
+  // Full KAMA series over a contiguous close array. out[i] is NaN until the
+  // seed at period - 1. The smoothing constants are computed in a separate
+  // branch-free pass so the compiler can vectorize the divisions; only the
+  // rolling sum and the final recurrence stay scalar. Matches calculateKAMA
+  // bit for bit at every index.
+  void calculateKAMASeries(const double *closes, size_t count, size_t period,
+                           double *out) {
+    if (period == 0 || count < period) {
+      throw std::invalid_argument("Not enough data to calculate KAMA.");
     }
 
-    double gain = 0.0, loss = 0.0;
-
-    for (size_t i = 1; i <= period; ++i) {
-      double change = candles[i].closingPrice - candles[i - 1].closingPrice;
-      if (change > 0) {
-        gain += change;
+    // Rolling volatility, stored in out[] until the last pass.
+    double volatility = 0.0;
+    for (size_t i = 1; i < count; ++i) {
+      double change = std::abs(closes[i] - closes[i - 1]);
+      if (i <= period) {
+        volatility += change;
       } else {
-        loss -= change;
+        volatility +=
+            change - std::abs(closes[i - period] - closes[i - period - 1]);
       }
+      out[i] = volatility;
     }
-    gain /= period;
-    loss /= period;
 
-    for (size_t i = period + 1; i < candles.size(); ++i) {
-      double change = candles[i].closingPrice - candles[i - 1].closingPrice;
-      if (change > 0) {
-        gain = (gain * (period - 1) + change) / period;
-        loss = (loss * (period - 1)) / period;
-      } else {
-        gain = (gain * (period - 1)) / period;
-        loss = (loss * (period - 1) - change) / period;
-      }
+    kamaConstants(closes, out, period, count);
+
+    for (size_t i = 0; i + 1 < period; ++i) {
+      out[i] = std::numeric_limits<double>::quiet_NaN();
+    }
+    double kama = closes[period - 1];
+    out[period - 1] = kama;
+    for (size_t i = period; i < count; ++i) {
+      kama += out[i] * (closes[i] - kama);
+      out[i] = kama;
     }
+  }
 
-    double rs = (loss == 0.0) ? 100.0 : gain / loss;
-    double rsi = 100.0 - (100.0 / (1.0 + rs));
+  std::vector<double>
+  calculateKAMASeries(const std::vector<Coinbase::Candle> &candles,
+                      size_t period = 10) {
+    std::vector<double> closes;
+    closes.reserve(candles.size());
+    for (const auto &candle : candles)
+      closes.push_back(candle.closingPrice);
 
-    return rsi;
+    std::vector<double> kama(closes.size());
+    calculateKAMASeries(closes.data(), closes.size(), period, kama.data());
+    return kama;
+  }
+
+  double calculateRSI(const std::vector<Coinbase::Candle> &candles,
+                      size_t period = 14) {
+    return rsiOver(
+        [&candles](size_t i) { return candles[i].closingPrice; },
+        candles.size(), period);
+  }
+
+  double calculateRSI(Span<double> closes, size_t period = 14) {
+    return rsiOver([closes](size_t i) { return closes[i]; }, closes.size(),
+               period);
+  }
+
+  double calculateRSI(const CandleSeries &series, size_t period = 14) {
+    return calculateRSI(series.close(), period);
   }
 
   std::vector<double> calculateEMA(const std::vector<double> &prices,
@@ -131,6 +185,37 @@ public:
     return {macdLine.back(), signalLine.back(), histogram};
   }
 
+  // Same values as the vector overload, computed in one pass over the close
+  // column with running EMAs instead of five temporary vectors.
+  MACDResult calculateMACD(Span<double> closes, int shortPeriod = 12,
+                           int longPeriod = 26, int signalPeriod = 9) {
+    if (closes.empty()) {
+      throw std::invalid_argument("Not enough data to calculate MACD.");
+    }
+    const double shortMultiplier = 2.0 / (shortPeriod + 1);
+    const double longMultiplier = 2.0 / (longPeriod + 1);
+    const double signalMultiplier = 2.0 / (signalPeriod + 1);
+
+    double shortEMA = closes[0];
+    double longEMA = closes[0];
+    double macdLine = shortEMA - longEMA;
+    double signalLine = macdLine;
+    for (size_t i = 1; i < closes.size(); ++i) {
+      shortEMA = (closes[i] - shortEMA) * shortMultiplier + shortEMA;
+      longEMA = (closes[i] - longEMA) * longMultiplier + longEMA;
+      macdLine = shortEMA - longEMA;
+      signalLine = (macdLine - signalLine) * signalMultiplier + signalLine;
+    }
+
+    return {macdLine, signalLine, macdLine - signalLine};
+  }
+
+  MACDResult calculateMACD(const CandleSeries &series, int shortPeriod = 12,
+                           int longPeriod = 26, int signalPeriod = 9) {
+    return calculateMACD(series.close(), shortPeriod, longPeriod,
+                         signalPeriod);
+  }
+
   void writeAnalysisToFile(const std::string &fileName,
                            const std::string &data) {
     std::ofstream file(fileName,
@@ -142,40 +227,161 @@ public:
     file.close();
   }
 
+  // Allocating convenience wrapper; hot paths and worker threads use
+  // TimestampFormat::format into their own buffer.
   std::string convertToTimestamp(time_t unixtime) {
-    std::tm *timeStruct = std::localtime(&unixtime);
-    char buffer[100];
-    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", timeStruct);
-    return std::string(buffer);
+    char buffer[TimestampFormat::Length];
+    return std::string(
+        buffer, TimestampFormat::format(unixtime, buffer, sizeof(buffer)));
   }
 
+  // Rescales every normalized_price in one batch. The live chart does not
+  // call this per fetch; it normalizes at draw time against a PriceScale
+  // that is updated per result (see price_scale.h).
   void normalizeData(std::vector<Result> &prices) {
+    if (prices.empty()) {
+      return;
+    }
+    auto element = std::minmax_element(
+        prices.begin(), prices.end(),
+        [](const Result &a, const Result &b) { return a.price < b.price; });
+    const double min_price = element.first->price;
+    const double max_price = element.second->price;
+    if (min_price == max_price) {
+      return;
+    }
+
+    for (auto &res : prices) {
+      res.normalized_price = (res.price - min_price) / (max_price - min_price);
+    }
+  }
 
-    std::vector<double> tmp;
-    for (const auto &i : prices)
-      tmp.push_back(i.price);
+  // Formats the analysis line resultToString returns into `out` without
+  // heap allocation; numbers use the same six-decimal fixed notation as
+  // std::to_string. Returns the length written (truncated to fit).
+  static size_t formatResult(const Result &res, char *out, size_t size) {
+    char *p = out;
+    char *end = out + size;
+
+    p += TimestampFormat::format(res.timestamp, p, end - p);
+
+    p = appendText(p, end, "\t MACD Line");
+    p = appendFixed(p, end, res.macd.macdLine);
+    p = appendText(p, end, "\t Signal Line");
+    p = appendFixed(p, end, res.macd.signalLine);
+    p = appendText(p, end, "\t Price: ");
+    p = appendFixed(p, end, res.price);
+    p = appendText(p, end, "\t KAMA: ");
+    p = appendFixed(p, end, res.kama);
+    p = appendText(p, end, "\t RSI: ");
+    p = appendFixed(p, end, res.rsi);
+    p = appendText(p, end, "\t ");
+    p = appendText(p, end, signalName(res.signal));
+    return static_cast<size_t>(p - out);
+  }
 
-    auto element = std::minmax_element(tmp.begin(), tmp.end());
-    auto min_price = *element.first;
-    auto max_price = *element.second;
+  std::string resultToString(const Result &res) {
+    char buffer[512];
+    return std::string(buffer, formatResult(res, buffer, sizeof(buffer)));
+  }
 
-    for (size_t i = 0; i < prices.size(); i++) {
-      if (min_price != max_price)
-        prices[i].normalized_price = static_cast<double>(
-            (prices.at(i).price - min_price) / (max_price - min_price));
+private:
+  // out[i] = kamaSmoothingConstant(|c[i] - c[i - period]|, out[i]) for
+  // i >= period, written with selects instead of branches. GCC only
+  // if-converts the selects without trapping math (the results are the same
+  // either way), and -O2 alone does not vectorize a loop of unknown length,
+  // hence the attribute.
+  __attribute__((optimize("no-trapping-math", "tree-loop-vectorize",
+                          "vect-cost-model=dynamic"))) static void
+  kamaConstants(const double *__restrict closes, double *__restrict out,
+                size_t period, size_t count) {
+    const double fastestSC = 2.0 / (2 + 1);
+    const double slowestSC = 2.0 / (30 + 1);
+    for (size_t i = period; i < count; ++i) {
+      const double volatility = out[i];
+      const bool moved = volatility > 0.0;
+      double er = std::fabs(closes[i] - closes[i - period]) /
+                  (moved ? volatility : 1.0);
+      er = 1.0 < er ? 1.0 : er;
+      er = moved ? er : 0.0;
+      const double sc = er * (fastestSC - slowestSC) + slowestSC;
+      out[i] = sc * sc;
     }
   }
 
-  std::string resultToString(Result res) {
-    std::string result = convertToTimestamp(res.timestamp) + "\t MACD Line" +
-                         std::to_string(res.macd.macdLine) + "\t Signal Line" +
-                         std::to_string(res.macd.signalLine) +
-                         "\t Price: " + std::to_string(res.price) +
-                         "\t KAMA: " + std::to_string(res.kama) +
-                         "\t RSI: " + std::to_string(res.rsi) + "\t " +
-                         res.signal;
+  static char *appendText(char *p, char *end, const char *text) {
+    size_t n = std::min(std::strlen(text), static_cast<size_t>(end - p));
+    std::memcpy(p, text, n);
+    return p + n;
+  }
+
+  static char *appendFixed(char *p, char *end, double value) {
+    auto written = std::to_chars(p, end, value, std::chars_format::fixed, 6);
+    return written.ec == std::errc() ? written.ptr : p;
+  }
+
+  template <typename CloseAt>
+  double kamaOver(CloseAt close, size_t count, size_t period) {
+    if (period == 0 || count < period) {
+      throw std::invalid_argument("Not enough data to calculate KAMA.");
+    }
+
+    double kama = close(period - 1);
+    double volatility = 0.0;
+
+    for (size_t i = 1; i < count; ++i) {
+      double change = std::abs(close(i) - close(i - 1));
+      if (i <= period) {
+        volatility += change;
+      } else {
+        volatility +=
+            change - std::abs(close(i - period) - close(i - period - 1));
+      }
+
+      if (i >= period) {
+        double priceChange = std::abs(close(i) - close(i - period));
+        kama += kamaSmoothingConstant(priceChange, volatility) *
+                (close(i) - kama);
+      }
+    }
+
+    return kama;
+  }
+
+  template <typename CloseAt>
+  double rsiOver(CloseAt close, size_t count, size_t period) {
+    if (count < period + 1) {
+      throw std::invalid_argument("Not enough data to calculate RSI.");
+    }
+
+    double gain = 0.0, loss = 0.0;
+
+    for (size_t i = 1; i <= period; ++i) {
+      double change = close(i) - close(i - 1);
+      if (change > 0) {
+        gain += change;
+      } else {
+        loss -= change;
+      }
+    }
+    gain /= period;
+    loss /= period;
 
-    return result;
+    for (size_t i = period + 1; i < count; ++i) {
+      double change = close(i) - close(i - 1);
+      if (change > 0) {
+        gain = (gain * (period - 1) + change) / period;
+        loss = (loss * (period - 1)) / period;
+      } else {
+        gain = (gain * (period - 1)) / period;
+        loss = (loss * (period - 1) - change) / period;
+      }
+    }
+
+    double rs = (loss == 0.0) ? 100.0 : gain / loss;
+    double rsi = 100.0 - (100.0 / (1.0 + rs));
+
+    return rsi;
   }
 };
 
@@ -0,0 +1,232 @@
+#ifndef PARAMETER_SWEEP_H
+#define PARAMETER_SWEEP_H
+
+#include "batch_indicators.h"
+#include "candle_series.h"
+#include "fixed_price.h"
+#include "indicators.h"
+#include "signals.h"
+#include "strategy.h"
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <random>
+#include <tuple>
+#include <vector>
+
+// Scores many indicator-period combinations over one candle history. Every
+// distinct KAMA period, RSI period and MACD triple is computed once as a full
+// series, then each combination only runs the signal rule and the trade tally
+// over the shared series. Both phases are spread over a work-stealing pool.
+// The series come from BatchIndicators, which match the streaming states in
+// IndicatorEngine bit for bit.
+class ParameterSweep {
+public:
+  using Periods = IndicatorEngine::Periods;
+
+  struct Range {
+    int first;
+    int last;
+    int step;
+
+    std::vector<int> values() const {
+      std::vector<int> out;
+      for (int v = first; v <= last && step > 0; v += step) {
+        out.push_back(v);
+      }
+      return out;
+    }
+  };
+
+  struct Grid {
+    Range kama{5, 30, 5};
+    Range rsi{7, 28, 7};
+    Range macdShort{8, 16, 4};
+    Range macdLong{20, 32, 6};
+    Range macdSignal{5, 13, 4};
+  };
+
+  struct Entry {
+    Periods periods;
+    DecisionStats stats;
+    size_t trades = 0;
+    size_t wins = 0;
+    double pnl = 0.0;
+  };
+
+  // `series` must be oldest first and outlive the sweep. With a quote
+  // increment PnL is tallied in exact ticks, as in Backtest.
+  ParameterSweep(const CandleSeries &series, WorkStealingPool &pool,
+                 const QuoteIncrement &increment = {})
+      : series(series), pool(pool), increment(increment) {}
+
+  // Every combination in the grid with macdShort < macdLong.
+  static std::vector<Periods> grid(const Grid &g) {
+    std::vector<Periods> combos;
+    for (int kama : g.kama.values()) {
+      for (int rsi : g.rsi.values()) {
+        for (int shortPeriod : g.macdShort.values()) {
+          for (int longPeriod : g.macdLong.values()) {
+            if (shortPeriod >= longPeriod) {
+              continue;
+            }
+            for (int signalPeriod : g.macdSignal.values()) {
+              combos.push_back({static_cast<size_t>(kama),
+                                static_cast<size_t>(rsi), shortPeriod,
+                                longPeriod, signalPeriod});
+            }
+          }
+        }
+      }
+    }
+    return combos;
+  }
+
+  // `count` grid points drawn uniformly without replacement.
+  static std::vector<Periods> sample(const Grid &g, size_t count,
+                                     unsigned seed) {
+    std::vector<Periods> combos = grid(g);
+    std::mt19937 rng(seed);
+    std::shuffle(combos.begin(), combos.end(), rng);
+    combos.resize(std::min(count, combos.size()));
+    return combos;
+  }
+
+  // Scores every combination; the result is ranked by PnL, best first, with
+  // ties kept in `combos` order so the ranking is reproducible.
+  std::vector<Entry> run(const std::vector<Periods> &combos) {
+    prepare(combos);
+
+    std::vector<Entry> entries(combos.size());
+    for (size_t i = 0; i < combos.size(); ++i) {
+      pool.submit([this, &combos, &entries, i] {
+        entries[i] = evaluate(combos[i]);
+      });
+    }
+    pool.wait();
+
+    std::stable_sort(
+        entries.begin(), entries.end(),
+        [](const Entry &a, const Entry &b) { return a.pnl > b.pnl; });
+    return entries;
+  }
+
+private:
+  struct Series {
+    std::vector<double> values;
+    size_t firstReady = 0; // first index the streaming state was ready at
+  };
+
+  struct MacdSeries {
+    std::vector<double> line;
+    std::vector<double> signal;
+  };
+
+  using MacdKey = std::tuple<int, int, int>;
+
+  // Computes each distinct indicator series once, in parallel.
+  void prepare(const std::vector<Periods> &combos) {
+    for (const auto &p : combos) {
+      kamaSeries.emplace(p.kama, Series{});
+      rsiSeries.emplace(p.rsi, Series{});
+      macdSeries.emplace(MacdKey{p.macdShort, p.macdLong, p.macdSignal},
+                         MacdSeries{});
+    }
+
+    for (auto &entry : kamaSeries) {
+      if (entry.second.values.empty()) {
+        pool.submit([this, &entry] {
+          entry.second = kama(entry.first);
+        });
+      }
+    }
+    for (auto &entry : rsiSeries) {
+      if (entry.second.values.empty()) {
+        pool.submit([this, &entry] {
+          entry.second = rsi(entry.first);
+        });
+      }
+    }
+    for (auto &entry : macdSeries) {
+      if (entry.second.line.empty()) {
+        pool.submit([this, &entry] { entry.second = macd(entry.first); });
+      }
+    }
+    pool.wait();
+  }
+
+  // firstReady is the first index IndicatorEngine would report as ready.
+  Series kama(size_t period) const {
+    Span<double> close = series.close();
+    Series out;
+    out.values.resize(close.size());
+    out.firstReady = close.size();
+    if (period > 0 && close.size() >= period) {
+      batch.kama(close.begin(), close.size(), period, out.values.data());
+      out.firstReady = period - 1;
+    }
+    return out;
+  }
+
+  Series rsi(size_t period) const {
+    Span<double> close = series.close();
+    Series out;
+    out.values.resize(close.size());
+    out.firstReady = close.size();
+    if (period > 0 && close.size() >= period + 1) {
+      batch.rsi(close.begin(), close.size(), period, out.values.data());
+      out.firstReady = period;
+    }
+    return out;
+  }
+
+  MacdSeries macd(const MacdKey &key) const {
+    Span<double> close = series.close();
+    MacdSeries out;
+    out.line.resize(close.size());
+    out.signal.resize(close.size());
+    batch.macd(close.begin(), close.size(), std::get<0>(key), std::get<1>(key),
+               std::get<2>(key), out.line.data(), out.signal.data(), nullptr);
+    return out;
+  }
+
+  // Same decisions as Backtest::run with these periods.
+  Entry evaluate(const Periods &periods) const {
+    const Series &kama = kamaSeries.at(periods.kama);
+    const Series &rsi = rsiSeries.at(periods.rsi);
+    const MacdSeries &macd = macdSeries.at(
+        MacdKey{periods.macdShort, periods.macdLong, periods.macdSignal});
+    Span<double> close = series.close();
+    Span<time_t> time = series.time();
+
+    TradeTally tally(increment);
+    for (size_t i = std::max(kama.firstReady, rsi.firstReady);
+         i < close.size(); ++i) {
+      tally.record(MacdRsiKamaStrategy::decide(macd.line[i], macd.signal[i],
+                                               rsi.values[i], close[i],
+                                               kama.values[i]),
+                   time[i], close[i]);
+    }
+
+    Entry entry;
+    entry.periods = periods;
+    entry.stats = tally.stats();
+    entry.trades = tally.trades().size();
+    entry.pnl = tally.pnl();
+    for (const auto &trade : tally.trades()) {
+      entry.wins += trade.pnl > 0;
+    }
+    return entry;
+  }
+
+  const CandleSeries &series;
+  WorkStealingPool &pool;
+  QuoteIncrement increment;
+  BatchIndicators batch;
+  std::map<size_t, Series> kamaSeries;
+  std::map<size_t, Series> rsiSeries;
+  std::map<MacdKey, MacdSeries> macdSeries;
+};
+
+#endif // PARAMETER_SWEEP_H
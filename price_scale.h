@@ -0,0 +1,110 @@
+#ifndef PRICE_SCALE_H
+#define PRICE_SCALE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+// Minimum and maximum over the most recent `window` values, kept in two
+// monotonic deques: each value is pushed and popped at most once, so push()
+// is O(1) amortized and the extremes are read off the fronts.
+class SlidingMinMax {
+public:
+  explicit SlidingMinMax(size_t window) : window(window ? window : 1) {}
+
+  void push(double value) {
+    while (!lows.empty() && lows.back().second >= value) {
+      lows.pop_back();
+    }
+    lows.emplace_back(count, value);
+    while (!highs.empty() && highs.back().second <= value) {
+      highs.pop_back();
+    }
+    highs.emplace_back(count, value);
+    ++count;
+
+    // Drop whatever fell out of the window.
+    const uint64_t oldest = count > window ? count - window : 0;
+    if (lows.front().first < oldest) {
+      lows.pop_front();
+    }
+    if (highs.front().first < oldest) {
+      highs.pop_front();
+    }
+  }
+
+  void clear() {
+    lows.clear();
+    highs.clear();
+    count = 0;
+  }
+
+  bool empty() const { return count == 0; }
+  // Only meaningful while !empty().
+  double min() const { return lows.front().second; }
+  double max() const { return highs.front().second; }
+  size_t windowSize() const { return window; }
+
+private:
+  size_t window;
+  uint64_t count = 0;
+  std::deque<std::pair<uint64_t, double>> lows;  // increasing values
+  std::deque<std::pair<uint64_t, double>> highs; // decreasing values
+};
+
+// Maps prices to [0, 1] the way Operations::normalizeData does, but updated
+// one price at a time. Scales over the whole history (window 0) with a
+// running min/max, or over the latest `window` prices with SlidingMinMax.
+// version() changes only when the extremes do, so callers can keep derived
+// values until the scale actually moves.
+class PriceScale {
+public:
+  explicit PriceScale(size_t window = 0) : sliding(window), window(window) {}
+
+  void push(double price) {
+    const double oldMin = low;
+    const double oldMax = high;
+    if (window > 0) {
+      sliding.push(price);
+      low = sliding.min();
+      high = sliding.max();
+    } else if (count == 0) {
+      low = high = price;
+    } else {
+      low = std::min(low, price);
+      high = std::max(high, price);
+    }
+    if (count == 0 || low != oldMin || high != oldMax) {
+      ++changes;
+    }
+    ++count;
+  }
+
+  void clear() {
+    sliding.clear();
+    count = 0;
+    low = high = 0.0;
+    ++changes;
+  }
+
+  double normalize(double price) const {
+    return high != low ? (price - low) / (high - low) : 0.0;
+  }
+
+  double min() const { return low; }
+  double max() const { return high; }
+  size_t size() const { return count; }
+  uint64_t version() const { return changes; }
+
+private:
+  SlidingMinMax sliding;
+  size_t window;
+  size_t count = 0;
+  double low = 0.0;
+  double high = 0.0;
+  uint64_t changes = 0;
+};
+
+#endif // PRICE_SCALE_H
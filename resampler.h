@@ -0,0 +1,183 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include "candle_series.h"
+#include "indicators.h"
+#include <algorithm>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Builds higher-timeframe OHLCV bars (5m, 15m, 1h, ...) from one base candle
+// stream, so every timeframe comes from a single fetch and they all agree on
+// the same trades. Bars are aligned to the epoch like the exchange's own
+// candles (a 1d bar starts at 00:00 UTC) and each timeframe feeds its own
+// IndicatorEngine. A bar closes as soon as the base candle that ends it
+// arrives, or when a later base candle skips past it (no trades). The bucket
+// the base stream starts in is skipped unless the stream starts on its
+// boundary, so no bar is built from part of its bucket. Slow timeframes can
+// be seeded with bars fetched at their own granularity, so their indicators
+// are ready without weeks of base candles.
+class Resampler {
+public:
+  // 5m, 15m, 1h, 6h and 1d, less those `base` cannot build.
+  static std::vector<int> defaultTimeframes(int base) {
+    std::vector<int> timeframes;
+    for (int granularity :
+         {5 * 60, 15 * 60, 60 * 60, 6 * 60 * 60, 24 * 60 * 60}) {
+      if (base > 0 && granularity > base && granularity % base == 0) {
+        timeframes.push_back(granularity);
+      }
+    }
+    return timeframes;
+  }
+
+  // Every timeframe must be a multiple of base_granularity.
+  Resampler(int base_granularity, const std::vector<int> &timeframes,
+            const IndicatorEngine::Periods &periods = {})
+      : base(base_granularity) {
+    if (base <= 0) {
+      throw std::invalid_argument("Base granularity must be positive.");
+    }
+    for (int granularity : timeframes) {
+      if (granularity < base || granularity % base != 0) {
+        throw std::invalid_argument(
+            "Timeframe " + std::to_string(granularity) +
+            " is not a multiple of the base granularity.");
+      }
+      frames.push_back(Frame{granularity, IndicatorEngine(periods), {}, {},
+                             false, 0, false});
+      sizes.push_back(granularity);
+    }
+  }
+
+  // Folds the next base candle in; candles at or before the last one are
+  // ignored. onBar(granularity, bar, engine) runs for every bar this closes,
+  // after the bar has been added to that timeframe's engine.
+  template <typename OnBar> void update(const Candle &candle, OnBar onBar) {
+    if (updates > 0 && candle.timestamp <= lastBase) {
+      return;
+    }
+    lastBase = candle.timestamp;
+    ++updates;
+
+    for (Frame &frame : frames) {
+      const std::time_t bucket =
+          candle.timestamp - candle.timestamp % frame.granularity;
+      if (!frame.started) {
+        frame.from = bucket == candle.timestamp
+                         ? bucket
+                         : bucket + frame.granularity; // partial bucket
+        frame.started = true;
+      }
+      if (bucket < frame.from) {
+        continue;
+      }
+      if (frame.open && bucket != frame.bar.timestamp) {
+        close(frame, onBar); // the rest of the old bucket had no trades
+      }
+      if (!frame.open) {
+        frame.bar = candle;
+        frame.bar.timestamp = bucket;
+        frame.open = true;
+      } else {
+        frame.bar.high = std::max(frame.bar.high, candle.high);
+        frame.bar.low = std::min(frame.bar.low, candle.low);
+        frame.bar.closingPrice = candle.closingPrice;
+        frame.bar.volume += candle.volume;
+      }
+      if (candle.timestamp + base >= bucket + frame.granularity) {
+        close(frame, onBar);
+      }
+    }
+  }
+
+  void update(const Candle &candle) {
+    update(candle, [](int, const Candle &, const IndicatorEngine &) {});
+  }
+
+  // Feeds complete `granularity` bars (oldest first) that end at `end`, e.g.
+  // fetched from the exchange at that granularity, into the timeframe's
+  // engine. Base candles before `end` are then ignored by this timeframe, so
+  // call it before the first update().
+  void seed(int granularity, const CandleSeries &seedBars, std::time_t end) {
+    Frame &frame = find(granularity);
+    for (size_t i = 0; i < seedBars.size(); ++i) {
+      const Candle bar = seedBars.at(i);
+      if (bar.timestamp + frame.granularity > end ||
+          (frame.engine.size() > 0 &&
+           bar.timestamp <= frame.engine.lastCandleTime())) {
+        continue;
+      }
+      frame.engine.update(bar);
+      frame.bars.append(bar);
+    }
+    frame.from = std::max(frame.from, end);
+    frame.started = true;
+  }
+
+  const std::vector<int> &timeframes() const { return sizes; }
+  int baseGranularity() const { return base; }
+
+  // Indicator state after the last closed bar of `granularity`.
+  const IndicatorEngine &indicators(int granularity) const {
+    return find(granularity).engine;
+  }
+
+  // Closed bars of `granularity`, oldest first.
+  const CandleSeries &bars(int granularity) const {
+    return find(granularity).bars;
+  }
+
+  // The bar still being built, for charts that show the forming bar.
+  bool partial(int granularity, Candle &out) const {
+    const Frame &frame = find(granularity);
+    if (frame.open) {
+      out = frame.bar;
+    }
+    return frame.open;
+  }
+
+private:
+  struct Frame {
+    int granularity;
+    IndicatorEngine engine;
+    CandleSeries bars;
+    Candle bar;
+    bool open;
+    std::time_t from; // first bucket this timeframe builds from base candles
+    bool started;
+  };
+
+  template <typename OnBar> void close(Frame &frame, OnBar &onBar) {
+    frame.open = false;
+    frame.engine.update(frame.bar);
+    frame.bars.append(frame.bar);
+    onBar(frame.granularity, static_cast<const Candle &>(frame.bar),
+          static_cast<const IndicatorEngine &>(frame.engine));
+  }
+
+  const Frame &find(int granularity) const {
+    for (const Frame &frame : frames) {
+      if (frame.granularity == granularity) {
+        return frame;
+      }
+    }
+    throw std::invalid_argument("Unknown timeframe " +
+                                std::to_string(granularity));
+  }
+
+  Frame &find(int granularity) {
+    return const_cast<Frame &>(
+        static_cast<const Resampler *>(this)->find(granularity));
+  }
+
+  int base;
+  std::vector<Frame> frames;
+  std::vector<int> sizes;
+  std::time_t lastBase = 0;
+  size_t updates = 0;
+};
+
+#endif // RESAMPLER_H
@@ -0,0 +1,165 @@
+#ifndef RESULT_HISTORY_H
+#define RESULT_HISTORY_H
+
+#include "operations.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+// The live session's results with bounded memory. The newest `capacity`
+// results live in a ring allocated once up front; older ones are spilled to
+// fixed-size segment files of compact records under spill_dir:
+//   <spill_dir>/results-<n>.seg
+// Each segment is created at full size and memory-mapped, so spilling is a
+// memcpy and reading old points back is a plain load. Index 0 is the first
+// result of the session whichever side it is on, so the chart and the
+// statistics read one view. Segments are scratch: they are removed when the
+// history is destroyed and stale ones are cleared on start.
+class ResultHistory {
+public:
+  struct Record {
+    int64_t time;
+    double price;
+    double macdLine;
+    double signalLine;
+    double kama;
+    double rsi;
+    float normalizedTimestamp;
+    uint8_t signal;
+    uint8_t reserved[3];
+  };
+  static_assert(sizeof(Record) == 56, "ResultHistory record layout changed");
+
+  static constexpr size_t SegmentRecords = 16384; // ~900 KB per segment
+
+  ResultHistory(size_t capacity, const std::string &spill_dir)
+      : ring(capacity ? capacity : 1), dir(spill_dir) {
+    std::filesystem::create_directories(dir);
+    for (const auto &entry : std::filesystem::directory_iterator(dir)) {
+      const std::string name = entry.path().filename().string();
+      if (name.compare(0, 8, "results-") == 0 &&
+          entry.path().extension() == ".seg") {
+        std::filesystem::remove(entry.path());
+      }
+    }
+  }
+
+  ~ResultHistory() {
+    for (size_t i = 0; i < segments.size(); ++i) {
+      munmap(segments[i], SegmentRecords * sizeof(Record));
+      ::unlink(segmentPath(i).c_str());
+    }
+  }
+
+  ResultHistory(const ResultHistory &) = delete;
+  ResultHistory &operator=(const ResultHistory &) = delete;
+
+  // O(1) and allocation-free except when a new segment is started.
+  void push(const Result &res) {
+    if (held == ring.size()) {
+      spill(ring[head]);
+      ring[head] = res;
+      head = (head + 1) % ring.size();
+      return;
+    }
+    ring[(head + held) % ring.size()] = res;
+    ++held;
+  }
+
+  size_t size() const { return spilled + held; }
+  bool empty() const { return size() == 0; }
+  size_t capacity() const { return ring.size(); }
+  size_t spilledCount() const { return spilled; }
+  // First index still held in memory.
+  size_t firstInMemory() const { return spilled; }
+
+  // Result i of the session, 0 being the oldest. Spilled results come back
+  // without normalized_price, which is only ever derived at draw time.
+  Result operator[](size_t i) const {
+    if (i >= spilled) {
+      return ring[(head + (i - spilled)) % ring.size()];
+    }
+    return fromRecord(segments[i / SegmentRecords][i % SegmentRecords]);
+  }
+
+  Result front() const { return (*this)[0]; }
+  const Result &back() const {
+    return ring[(head + held - 1) % ring.size()];
+  }
+
+private:
+  static Record toRecord(const Result &res) {
+    Record r{};
+    r.time = static_cast<int64_t>(res.timestamp);
+    r.price = res.price;
+    r.macdLine = res.macd.macdLine;
+    r.signalLine = res.macd.signalLine;
+    r.kama = res.kama;
+    r.rsi = res.rsi;
+    r.normalizedTimestamp = static_cast<float>(res.normalized_timestamp);
+    r.signal = static_cast<uint8_t>(res.signal);
+    return r;
+  }
+
+  static Result fromRecord(const Record &r) {
+    Result res;
+    res.timestamp = static_cast<time_t>(r.time);
+    res.macd = {r.macdLine, r.signalLine, r.macdLine - r.signalLine};
+    res.price = r.price;
+    res.normalized_price = 0.0;
+    res.normalized_timestamp = r.normalizedTimestamp;
+    res.kama = r.kama;
+    res.rsi = r.rsi;
+    res.signal = static_cast<Signal>(r.signal);
+    return res;
+  }
+
+  std::string segmentPath(size_t n) const {
+    return dir + "/results-" + std::to_string(n) + ".seg";
+  }
+
+  void spill(const Result &res) {
+    if (spilled % SegmentRecords == 0) {
+      openSegment();
+    }
+    segments.back()[spilled % SegmentRecords] = toRecord(res);
+    ++spilled;
+  }
+
+  void openSegment() {
+    const std::string path = segmentPath(segments.size());
+    const size_t bytes = SegmentRecords * sizeof(Record);
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      throw std::runtime_error("Unable to open result segment " + path +
+                               ": " + std::strerror(errno));
+    }
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+      ::close(fd);
+      throw std::runtime_error("Unable to size result segment " + path);
+    }
+    void *mapping =
+        mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file open
+    if (mapping == MAP_FAILED) {
+      throw std::runtime_error("Unable to map result segment " + path);
+    }
+    segments.push_back(static_cast<Record *>(mapping));
+  }
+
+  std::vector<Result> ring;
+  size_t head = 0; // oldest result in the ring
+  size_t held = 0;
+  size_t spilled = 0;
+  std::string dir;
+  std::vector<Record *> segments;
+};
+
+#endif // RESULT_HISTORY_H
@@ -0,0 +1,175 @@
+#ifndef RESULT_WRITER_H
+#define RESULT_WRITER_H
+
+#include "operations.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Persistent replacement for Operations::writeAnalysisToFile. Rows are
+// formatted on the caller's stack and copied into a preallocated ring buffer;
+// a background thread drains the ring to the file. The hot path is a format
+// plus a memcpy under a short lock, never a syscall.
+class ResultWriter {
+public:
+  enum class FlushPolicy {
+    Interval,  // drain every flushInterval or when the ring is half full
+    Immediate, // wake the writer thread after every row
+  };
+
+  enum class SyncPolicy {
+    Never,      // leave durability to the kernel
+    EveryFlush, // fdatasync after each drain
+    OnClose,    // fdatasync once when the writer is destroyed
+  };
+
+  struct Options {
+    size_t bufferBytes = 1 << 20;
+    FlushPolicy flush = FlushPolicy::Interval;
+    SyncPolicy sync = SyncPolicy::Never;
+    std::chrono::milliseconds flushInterval{250};
+  };
+
+  explicit ResultWriter(const std::string &fileName)
+      : ResultWriter(fileName, Options{}) {}
+
+  ResultWriter(const std::string &fileName, const Options &options)
+      : options(options), ring(std::max<size_t>(options.bufferBytes, 4096)) {
+    fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+      throw std::runtime_error("Unable to open file for writing.");
+    }
+    thread = std::thread(&ResultWriter::run, this);
+  }
+
+  ~ResultWriter() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    dataReady.notify_one();
+    thread.join();
+    if (options.sync != SyncPolicy::Never) {
+      fdatasync(fd);
+    }
+    ::close(fd);
+  }
+
+  ResultWriter(const ResultWriter &) = delete;
+  ResultWriter &operator=(const ResultWriter &) = delete;
+
+  void write(const Result &res) {
+    char line[512];
+    size_t n = Operations::formatResult(res, line, sizeof(line) - 1);
+    line[n++] = '\n';
+    write(line, n);
+  }
+
+  // Appends raw bytes as one unit, so rows from concurrent callers never
+  // interleave. Blocks only while the ring lacks room for the whole row.
+  void write(const char *data, size_t size) {
+    size = std::min(size, ring.size());
+    std::unique_lock<std::mutex> lock(mutex);
+    if (ring.size() - used < size) {
+      dataReady.notify_one(); // full: let the writer drain
+      spaceFree.wait(lock, [this, size] { return ring.size() - used >= size; });
+    }
+    size_t tail = (head + used) % ring.size();
+    size_t first = std::min(size, ring.size() - tail);
+    std::memcpy(ring.data() + tail, data, first);
+    std::memcpy(ring.data(), data + first, size - first);
+    used += size;
+    if (options.flush == FlushPolicy::Immediate || used >= ring.size() / 2) {
+      lock.unlock();
+      dataReady.notify_one();
+    }
+  }
+
+  // Blocks until everything written so far has reached the file.
+  void flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    flushRequested = true;
+    dataReady.notify_one();
+    spaceFree.wait(lock, [this] { return used == 0 && !draining; });
+  }
+
+private:
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      dataReady.wait_for(lock, options.flushInterval, [this] {
+        return stopping || flushRequested || used >= ring.size() / 2 ||
+               (options.flush == FlushPolicy::Immediate && used > 0);
+      });
+      if (used > 0) {
+        drain(lock);
+      }
+      flushRequested = false;
+      spaceFree.notify_all();
+      if (stopping && used == 0) {
+        return;
+      }
+    }
+  }
+
+  // Writes the filled region without holding the lock; producers only touch
+  // the free part of the ring meanwhile.
+  void drain(std::unique_lock<std::mutex> &lock) {
+    size_t start = head;
+    size_t length = used;
+    draining = true;
+    lock.unlock();
+
+    size_t first = std::min(length, ring.size() - start);
+    writeAll(ring.data() + start, first);
+    writeAll(ring.data(), length - first);
+    if (options.sync == SyncPolicy::EveryFlush) {
+      fdatasync(fd);
+    }
+
+    lock.lock();
+    head = (start + length) % ring.size();
+    used -= length;
+    draining = false;
+  }
+
+  void writeAll(const char *data, size_t size) {
+    while (size > 0) {
+      ssize_t n = ::write(fd, data, size);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        std::cerr << "ResultWriter: " << std::strerror(errno) << std::endl;
+        return;
+      }
+      data += n;
+      size -= static_cast<size_t>(n);
+    }
+  }
+
+  Options options;
+  std::vector<char> ring;
+  size_t head = 0; // first unwritten byte
+  size_t used = 0; // bytes waiting to be written
+  bool draining = false;
+  bool flushRequested = false;
+  bool stopping = false;
+  int fd = -1;
+
+  std::mutex mutex;
+  std::condition_variable dataReady;
+  std::condition_variable spaceFree;
+  std::thread thread;
+};
+
+#endif // RESULT_WRITER_H
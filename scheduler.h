@@ -0,0 +1,136 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <random>
+
+// Decides when to fetch and which candles are due. Buckets are identified by
+// their start time; bucket t closes at t + granularity. The scheduler wakes
+// the caller just after the next bucket closes (plus a random jitter so many
+// clients don't hit the API in the same instant), backs off exponentially
+// after a failed fetch, and only advances past a window once the caller
+// reports it completed, so a missed or failed window is caught up on the next
+// wake. A bucket the exchange has not published yet stays due and is asked
+// for again until lateLimit has passed, after which it is taken as a bucket
+// without trades. Deadlines are steady_clock time points: waits are immune to
+// wall-clock steps, and the wall-clock boundary is re-derived on every call.
+class CandleScheduler {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Options {
+    std::chrono::milliseconds settle{1000}; // after the close, before fetching
+    std::chrono::milliseconds jitter{250};  // uniform extra delay, 0..jitter
+    std::chrono::milliseconds retryInitial{1000};
+    std::chrono::milliseconds retryMax{30000};
+    double backoff = 2.0;
+    std::chrono::milliseconds lateRetry{5000}; // re-ask for a missing bucket
+    std::chrono::seconds lateLimit{60}; // past its close it had no trades
+  };
+
+  // Closed buckets [start, end) still to be processed.
+  struct Window {
+    std::time_t start;
+    std::time_t end;
+    bool empty() const { return end <= start; }
+  };
+
+  // `resume_from` is the first bucket not processed yet; buckets before it
+  // are never reported.
+  CandleScheduler(int granularity, std::time_t resume_from)
+      : CandleScheduler(granularity, resume_from, Options{}) {}
+  CandleScheduler(int granularity, std::time_t resume_from,
+                  const Options &options)
+      : granularity(granularity), options(options),
+        processedEnd(resume_from - resume_from % granularity),
+        rng(std::random_device{}()) {}
+
+  // Start of the oldest bucket that is not closed and settled yet.
+  std::time_t closedEnd() const {
+    std::time_t now = std::chrono::system_clock::to_time_t(
+        std::chrono::system_clock::now() - options.settle);
+    return now - now % granularity;
+  }
+
+  Window due() const { return {processedEnd, closedEnd()}; }
+
+  // When the caller should next ask for due(). Immediately while a closed
+  // window is outstanding and no retry is pending.
+  Clock::time_point nextWake() {
+    const Clock::time_point now = Clock::now();
+    if (failures > 0) {
+      double delay = options.retryInitial.count() *
+                     std::pow(options.backoff, failures - 1);
+      delay = std::min(delay, static_cast<double>(options.retryMax.count()));
+      return lastFailure +
+             std::chrono::milliseconds(static_cast<long long>(delay)) +
+             jitter();
+    }
+    if (!due().empty()) {
+      return std::max(now, lateUntil);
+    }
+    // Next close, mapped from wall time onto the monotonic clock.
+    const auto wallNow = std::chrono::system_clock::now();
+    const auto close = std::chrono::system_clock::from_time_t(
+        processedEnd + granularity);
+    return now +
+           std::chrono::duration_cast<Clock::duration>(close - wallNow) +
+           options.settle + jitter();
+  }
+
+  // The window was fetched and processed; the next one starts at its end.
+  void completed(const Window &window) {
+    processedEnd = std::max(processedEnd, window.end);
+    failures = 0;
+    lateUntil = Clock::time_point();
+  }
+
+  // The window was fetched and `newest` is the start of the newest bucket
+  // that came back (0 for none). Buckets before it are done; later ones stay
+  // due, retried after lateRetry, until they are older than lateLimit.
+  void fetched(const Window &window, std::time_t newest) {
+    const std::time_t wallNow =
+        std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    if (newest + granularity >= window.end ||
+        wallNow >= window.end + options.lateLimit.count()) {
+      completed(window);
+      return;
+    }
+    processedEnd =
+        std::max(processedEnd, newest >= window.start ? newest + granularity
+                                                      : window.start);
+    failures = 0;
+    lateUntil = Clock::now() + options.lateRetry;
+  }
+
+  // The window failed; it stays due and the next wake is backed off.
+  void failed() {
+    ++failures;
+    lastFailure = Clock::now();
+  }
+
+  std::time_t processedUpTo() const { return processedEnd; }
+  int consecutiveFailures() const { return failures; }
+
+private:
+  std::chrono::milliseconds jitter() {
+    if (options.jitter.count() <= 0) {
+      return std::chrono::milliseconds(0);
+    }
+    std::uniform_int_distribution<long long> spread(0, options.jitter.count());
+    return std::chrono::milliseconds(spread(rng));
+  }
+
+  int granularity;
+  Options options;
+  std::time_t processedEnd;
+  int failures = 0;
+  Clock::time_point lastFailure;
+  Clock::time_point lateUntil; // no re-ask before this while a bucket is late
+  std::mt19937 rng;
+};
+
+#endif // SCHEDULER_H
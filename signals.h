@@ -0,0 +1,133 @@
+#ifndef SIGNALS_H
+#define SIGNALS_H
+
+#include "fixed_price.h"
+#include "operations.h"
+#include <ctime>
+#include <vector>
+
+// Decision bookkeeping shared by the GUI, the backtester and the sweep, so all
+// of them count trades the same way. The signals come from strategy.h.
+
+struct DecisionStats {
+  int buyCount = 0;
+  int sellCount = 0;
+  int buySuccessCount = 0;
+  int buyFailCount = 0;
+  int sellSuccessCount = 0;
+  int sellFailCount = 0;
+
+  bool operator==(const DecisionStats &o) const {
+    return buyCount == o.buyCount && sellCount == o.sellCount &&
+           buySuccessCount == o.buySuccessCount &&
+           buyFailCount == o.buyFailCount &&
+           sellSuccessCount == o.sellSuccessCount &&
+           sellFailCount == o.sellFailCount;
+  }
+  bool operator!=(const DecisionStats &o) const { return !(*this == o); }
+};
+
+// Pairs opposite signals into round trips. Repeated signals on the same side
+// move that leg to the latest price; the first opposite signal closes the
+// trip. A BUY closed by a SELL counts as a buy decision, a SELL closed by a
+// BUY as a sell decision, and either succeeds when it sold above the buy.
+//
+// Given a quote increment, prices are rounded to whole ticks as they are
+// recorded and PnL is summed in ticks, so the tally is exact and identical
+// on every machine; without one it works in doubles as before.
+class TradeTally {
+public:
+  struct Trade {
+    bool isLong; // opened by a BUY
+    std::time_t entryTime;
+    double entryPrice;
+    std::time_t exitTime;
+    double exitPrice;
+    double pnl;     // per unit, sell price minus buy price
+    Ticks pnlTicks; // the same in ticks; 0 without a quote increment
+  };
+
+  TradeTally() = default;
+  explicit TradeTally(const QuoteIncrement &increment)
+      : increment(increment) {}
+
+  // Returns true when `res` closed a trade.
+  bool record(const Result &res) {
+    return record(res.signal, res.timestamp, res.price);
+  }
+
+  bool record(Signal signal, std::time_t timestamp, double price) {
+    if (signal == Signal::Buy) {
+      ++decisions.buyCount;
+      return leg(true, timestamp, price);
+    }
+    if (signal == Signal::Sell) {
+      ++decisions.sellCount;
+      return leg(false, timestamp, price);
+    }
+    return false;
+  }
+
+  const DecisionStats &stats() const { return decisions; }
+  const std::vector<Trade> &trades() const { return closed; }
+  double pnl() const {
+    return increment.enabled() ? increment.toDouble(totalTicks) : totalPnl;
+  }
+  Ticks pnlTicks() const { return totalTicks; }
+  const QuoteIncrement &quoteIncrement() const { return increment; }
+  bool inPosition() const { return open; }
+
+  void reserve(size_t trades) { closed.reserve(trades); }
+
+private:
+  bool leg(bool isBuy, std::time_t timestamp, double price) {
+    const Ticks ticks = increment.enabled() ? increment.toTicks(price) : 0;
+    if (increment.enabled()) {
+      price = increment.toDouble(ticks);
+    }
+    if (!open || openIsLong == isBuy) {
+      open = true;
+      openIsLong = isBuy;
+      entryTime = timestamp;
+      entryPrice = price;
+      entryTicks = ticks;
+      return false;
+    }
+
+    Trade trade{openIsLong, entryTime, entryPrice, timestamp, price, 0.0, 0};
+    bool success;
+    if (increment.enabled()) {
+      trade.pnlTicks = openIsLong ? ticks - entryTicks : entryTicks - ticks;
+      trade.pnl = increment.toDouble(trade.pnlTicks);
+      success = trade.pnlTicks > 0;
+    } else {
+      const double buyPrice = openIsLong ? entryPrice : price;
+      const double sellPrice = openIsLong ? price : entryPrice;
+      trade.pnl = sellPrice - buyPrice;
+      success = trade.pnl > 0;
+    }
+    if (openIsLong) {
+      ++(success ? decisions.buySuccessCount : decisions.buyFailCount);
+    } else {
+      ++(success ? decisions.sellSuccessCount : decisions.sellFailCount);
+    }
+    totalPnl += trade.pnl;
+    totalTicks += trade.pnlTicks;
+    closed.push_back(trade);
+    open = false;
+    return true;
+  }
+
+  QuoteIncrement increment;
+  DecisionStats decisions;
+  std::vector<Trade> closed;
+  double totalPnl = 0.0;
+  Ticks totalTicks = 0;
+  bool open = false;
+  bool openIsLong = false;
+  std::time_t entryTime = 0;
+  double entryPrice = 0.0;
+  Ticks entryTicks = 0;
+};
+
+#endif // SIGNALS_H
@@ -0,0 +1,48 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. One slot is kept empty to tell "full" from "empty".
+template <typename T, size_t Capacity> class SpscQueue {
+  static_assert(Capacity >= 2, "SpscQueue needs at least two slots");
+
+public:
+  bool push(T &&item) {
+    const size_t tail = tailIndex.load(std::memory_order_relaxed);
+    const size_t next = (tail + 1) % Capacity;
+    if (next == headIndex.load(std::memory_order_acquire)) {
+      return false; // full
+    }
+    slots[tail] = std::move(item);
+    tailIndex.store(next, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T &item) {
+    const size_t head = headIndex.load(std::memory_order_relaxed);
+    if (head == tailIndex.load(std::memory_order_acquire)) {
+      return false; // empty
+    }
+    item = std::move(slots[head]);
+    headIndex.store((head + 1) % Capacity, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return headIndex.load(std::memory_order_acquire) ==
+           tailIndex.load(std::memory_order_acquire);
+  }
+
+private:
+  std::array<T, Capacity> slots;
+  // Producer and consumer indices live on separate cache lines.
+  alignas(64) std::atomic<size_t> headIndex{0};
+  alignas(64) std::atomic<size_t> tailIndex{0};
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,116 @@
+#ifndef STATS_PANEL_H
+#define STATS_PANEL_H
+
+#include "chart_renderer.h"
+#include "operations.h"
+#include "raylib.h"
+#include "signals.h"
+#include <cstdio>
+#include <ctime>
+
+// The statistics strip at the bottom of the window. Its text is formatted
+// and rendered into a RenderTexture2D only when a counter, the last signal or
+// the window width changes; every other frame just blits the texture.
+class StatsPanel {
+public:
+  static constexpr int Height = 250;
+
+  ~StatsPanel() { unload(); }
+
+  // Must run before CloseWindow() while the GL context still exists.
+  void unload() {
+    if (loaded) {
+      UnloadRenderTexture(target);
+      loaded = false;
+    }
+  }
+
+  // Call before BeginDrawing().
+  void update(const DecisionStats &stats, const Result &last,
+              int screenWidth) {
+    const bool resized = !loaded || screenWidth != width;
+    if (!resized && stats == shown && last.timestamp == lastTimestamp &&
+        last.signal == lastSignal) {
+      return;
+    }
+    if (resized) {
+      unload();
+      target = LoadRenderTexture(screenWidth, Height);
+      loaded = true;
+      width = screenWidth;
+    }
+    shown = stats;
+    lastTimestamp = last.timestamp;
+    lastSignal = last.signal;
+    render(ChartRenderer::signalColor(last.signal));
+  }
+
+  void draw(int screenWidth, int screenHeight) const {
+    DrawLineEx(
+        (Vector2){0.0f, screenHeight - static_cast<float>(Height)},
+        (Vector2){static_cast<float>(screenWidth),
+                  screenHeight - static_cast<float>(Height)},
+        4.0f, GRAY);
+    if (loaded) {
+      // Render textures are stored bottom-up, hence the negative height.
+      DrawTextureRec(target.texture,
+                     {0.0f, 0.0f, static_cast<float>(width),
+                      -static_cast<float>(Height)},
+                     {0.0f, static_cast<float>(screenHeight - Height)}, WHITE);
+    }
+  }
+
+private:
+  void render(Color signalColor) {
+    const int fontsize = 12 + 7;
+    const Color textColor = GRAY;
+    char buffer[100];
+
+    BeginTextureMode(target);
+    ClearBackground({33, 47, 61, 255});
+
+    std::snprintf(buffer, sizeof(buffer), "Total buy decision : %d",
+                  shown.buyCount);
+    DrawText(buffer, 50, 50, fontsize, textColor);
+
+    std::snprintf(buffer, sizeof(buffer), "Total sell decision : %d",
+                  shown.sellCount);
+    DrawText(buffer, 50, 80, fontsize, textColor);
+
+    std::snprintf(buffer, sizeof(buffer),
+                  "Total successfull buy decision : %d",
+                  shown.buySuccessCount);
+    DrawText(buffer, 50, 110, fontsize, textColor);
+
+    std::snprintf(buffer, sizeof(buffer), "Total failed buy decision : %d",
+                  shown.buyFailCount);
+    DrawText(buffer, 50, 140, fontsize, textColor);
+
+    std::snprintf(buffer, sizeof(buffer),
+                  "Total successfull sell decision : %d",
+                  shown.sellSuccessCount);
+    DrawText(buffer, 50, 170, fontsize, textColor);
+
+    std::snprintf(buffer, sizeof(buffer), "Total failed sell decision : %d",
+                  shown.sellFailCount);
+    DrawText(buffer, 50, 200, fontsize, textColor);
+
+    char timestamp[TimestampFormat::Length + 1];
+    timestamp[TimestampFormat::format(lastTimestamp, timestamp,
+                                      TimestampFormat::Length)] = '\0';
+    std::snprintf(buffer, sizeof(buffer), "Last signal : %s - %s",
+                  signalName(lastSignal), timestamp);
+    DrawText(buffer, width - 400, 50, fontsize, signalColor);
+
+    EndTextureMode();
+  }
+
+  RenderTexture2D target{};
+  bool loaded = false;
+  int width = 0;
+  DecisionStats shown;
+  std::time_t lastTimestamp = 0;
+  Signal lastSignal = Signal::Hold;
+};
+
+#endif // STATS_PANEL_H
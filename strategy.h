@@ -0,0 +1,125 @@
+#ifndef STRATEGY_H
+#define STRATEGY_H
+
+#include "indicators.h"
+#include "operations.h"
+#include <memory>
+#include <vector>
+
+// A trading rule judged against the indicator state after a candle. Rules
+// only read the shared IndicatorEngine, so any number of them can be
+// evaluated without recomputing an indicator.
+class Strategy {
+public:
+  virtual ~Strategy() = default;
+  virtual const char *name() const = 0;
+  // `engine` is ready() and already includes `candle`.
+  virtual Signal evaluate(const IndicatorEngine &engine,
+                          const Candle &candle) const = 0;
+};
+
+// The original rule: MACD above its signal line, RSI under 50 and the close
+// above KAMA is a BUY; the mirror image is a SELL; anything else is a HOLD.
+class MacdRsiKamaStrategy : public Strategy {
+public:
+  const char *name() const override { return "macd-rsi-kama"; }
+
+  Signal evaluate(const IndicatorEngine &engine,
+                  const Candle &candle) const override {
+    const MACDResult &macd = engine.macd();
+    return decide(macd.macdLine, macd.signalLine, engine.rsi(),
+                  candle.closingPrice, engine.kama());
+  }
+
+  // The rule on bare values, for callers that keep indicator series instead
+  // of an engine.
+  static Signal decide(double macdLine, double signalLine, double rsi,
+                       double close, double kama) {
+    if (macdLine > signalLine && rsi < 50 && close > kama) {
+      return Signal::Buy;
+    }
+    if (macdLine < signalLine && rsi > 50 && close < kama) {
+      return Signal::Sell;
+    }
+    return Signal::Hold;
+  }
+};
+
+// One indicator state shared by several strategies. Feed every closed candle
+// once through update(); evaluate() then asks each strategy in turn.
+class StrategyEngine {
+public:
+  StrategyEngine() : StrategyEngine(IndicatorEngine::Periods{}) {}
+  explicit StrategyEngine(const IndicatorEngine::Periods &periods)
+      : engine(periods), scratch(periods) {}
+
+  // Returns the index the strategy's signal is reported at.
+  size_t add(std::unique_ptr<Strategy> strategy) {
+    strategies.push_back(std::move(strategy));
+    current.push_back(Signal::Hold);
+    previewed.push_back(Signal::Hold);
+    return strategies.size() - 1;
+  }
+
+  void update(const Candle &candle) { engine.update(candle); }
+  bool ready() const { return engine.ready(); }
+
+  // Signals of every strategy for `candle`, in the order they were added.
+  const std::vector<Signal> &evaluate(const Candle &candle) {
+    for (size_t i = 0; i < strategies.size(); ++i) {
+      current[i] = strategies[i]->evaluate(engine, candle);
+    }
+    return current;
+  }
+
+  // Signals as if the still-open `partial` candle closed now, for tick by
+  // tick updates. Works on a scratch copy of the indicator state, so the
+  // closed-candle state is untouched; the copy reuses its buffers and does
+  // not allocate after the first call.
+  const std::vector<Signal> &preview(const Candle &partial) {
+    scratch = engine;
+    scratch.update(partial);
+    for (size_t i = 0; i < strategies.size(); ++i) {
+      previewed[i] = scratch.ready()
+                         ? strategies[i]->evaluate(scratch, partial)
+                         : Signal::Hold;
+    }
+    return previewed;
+  }
+
+  // Indicator state of the last preview().
+  const IndicatorEngine &previewIndicators() const { return scratch; }
+
+  // Indicator values at `candle` with strategy `index`'s signal.
+  Result result(const Candle &candle, size_t index = 0) const {
+    return result(engine, *strategies[index], candle);
+  }
+
+  // The same for any indicator state, e.g. a resampled timeframe's.
+  static Result result(const IndicatorEngine &indicators,
+                       const Strategy &strategy, const Candle &candle) {
+    Result res;
+    res.timestamp = candle.timestamp;
+    res.macd = indicators.macd();
+    res.price = candle.closingPrice;
+    res.normalized_price = 0.0;
+    res.normalized_timestamp = 60;
+    res.kama = indicators.kama();
+    res.rsi = indicators.rsi();
+    res.signal = strategy.evaluate(indicators, candle);
+    return res;
+  }
+
+  const IndicatorEngine &indicators() const { return engine; }
+  const Strategy &strategy(size_t index) const { return *strategies[index]; }
+  size_t size() const { return strategies.size(); }
+
+private:
+  IndicatorEngine engine;
+  std::vector<std::unique_ptr<Strategy>> strategies;
+  std::vector<Signal> current;
+  IndicatorEngine scratch;
+  std::vector<Signal> previewed;
+};
+
+#endif // STRATEGY_H
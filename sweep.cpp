@@ -0,0 +1,161 @@
+// Parameter sweep: ranks KAMA/RSI/MACD period combinations by the PnL the
+// signal rule would have made over cached history. Build with build.sh.
+//
+//   ./sweep [product] [granularity] [days] [cache_dir] [options]
+//
+// Options take a value each:
+//   --kama first:last:step       (default 5:30:5)
+//   --rsi first:last:step        (default 7:28:7)
+//   --macd-short first:last:step (default 8:16:4)
+//   --macd-long first:last:step  (default 20:32:6)
+//   --macd-signal first:last:step (default 5:13:4)
+//   --random N    score N grid points drawn at random instead of all of them
+//   --seed S      seed for --random (default 1)
+//   --threads N   worker threads (default: all cores)
+//   --top N       rows to print (default 20)
+//   --quote-increment X  tick size PnL is tallied in exactly (default 0.01)
+
+#include "backtest.h"
+#include "candle_store.h"
+#include "parameter_sweep.h"
+#include "work_stealing_pool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static bool parseRange(const char *text, ParameterSweep::Range &range) {
+  ParameterSweep::Range parsed{};
+  if (std::sscanf(text, "%d:%d:%d", &parsed.first, &parsed.last,
+                  &parsed.step) != 3 ||
+      parsed.first <= 0 || parsed.step <= 0 || parsed.last < parsed.first) {
+    return false;
+  }
+  range = parsed;
+  return true;
+}
+
+static int usage() {
+  std::cerr << "usage: sweep [product] [granularity] [days] [cache_dir]"
+               " [--kama a:b:s] [--rsi a:b:s] [--macd-short a:b:s]"
+               " [--macd-long a:b:s] [--macd-signal a:b:s] [--random N]"
+               " [--seed S] [--threads N] [--top N] [--quote-increment X]"
+            << std::endl;
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  std::vector<std::string> positional;
+  ParameterSweep::Grid grid;
+  size_t randomCount = 0;
+  unsigned seed = 1;
+  size_t threads = std::thread::hardware_concurrency();
+  size_t top = 20;
+  QuoteIncrement increment(1, 2);
+
+  for (int i = 1; i < argc; ++i) {
+    if (std::strncmp(argv[i], "--", 2) != 0) {
+      positional.push_back(argv[i]);
+      continue;
+    }
+    if (i + 1 >= argc) {
+      return usage();
+    }
+    const std::string option = argv[i];
+    const char *value = argv[++i];
+    bool ok = true;
+    if (option == "--kama") {
+      ok = parseRange(value, grid.kama);
+    } else if (option == "--rsi") {
+      ok = parseRange(value, grid.rsi);
+    } else if (option == "--macd-short") {
+      ok = parseRange(value, grid.macdShort);
+    } else if (option == "--macd-long") {
+      ok = parseRange(value, grid.macdLong);
+    } else if (option == "--macd-signal") {
+      ok = parseRange(value, grid.macdSignal);
+    } else if (option == "--random") {
+      randomCount = std::strtoul(value, nullptr, 10);
+    } else if (option == "--seed") {
+      seed = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+    } else if (option == "--threads") {
+      threads = std::strtoul(value, nullptr, 10);
+    } else if (option == "--top") {
+      top = std::strtoul(value, nullptr, 10);
+    } else if (option == "--quote-increment") {
+      ok = QuoteIncrement::parse(value, increment);
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      return usage();
+    }
+  }
+
+  const std::string productId =
+      positional.size() > 0 ? positional[0] : "BTC-USD";
+  const int granularity =
+      positional.size() > 1 ? std::atoi(positional[1].c_str()) : 60;
+  const int days = positional.size() > 2 ? std::atoi(positional[2].c_str())
+                                         : 365;
+  const std::string cacheDir = positional.size() > 3 ? positional[3] : "cache";
+  if (granularity <= 0 || days <= 0) {
+    return usage();
+  }
+
+  time_t end = std::time(nullptr);
+  end -= end % granularity;
+  time_t start = end - static_cast<time_t>(days) * 24 * 60 * 60;
+
+  CandleSeries series;
+  try {
+    CandleStore store(cacheDir, productId, granularity);
+    if (!Backtest::loadHistory(store, productId, granularity, start, end,
+                               series)) {
+      std::cerr << "Sweep: history incomplete, scoring what arrived"
+                << std::endl;
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "Sweep: " << e.what() << std::endl;
+    return 1;
+  }
+  if (series.empty()) {
+    std::cerr << "Sweep: no candles in range" << std::endl;
+    return 1;
+  }
+
+  std::vector<ParameterSweep::Periods> combos =
+      randomCount > 0 ? ParameterSweep::sample(grid, randomCount, seed)
+                      : ParameterSweep::grid(grid);
+
+  const auto started = std::chrono::steady_clock::now();
+  WorkStealingPool pool(threads);
+  ParameterSweep sweep(series, pool, increment);
+  std::vector<ParameterSweep::Entry> entries = sweep.run(combos);
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - started)
+                             .count();
+
+  std::printf("%s  granularity %d s  %zu candles  %zu combinations on %zu "
+              "threads in %.2f s\n\n",
+              productId.c_str(), granularity, series.size(), entries.size(),
+              pool.size(), seconds);
+  std::printf("%4s %5s %4s %10s %7s %7s %7s %7s %12s\n", "rank", "kama", "rsi",
+              "macd", "buys", "sells", "trades", "win %", "pnl/unit");
+  for (size_t i = 0; i < entries.size() && i < top; ++i) {
+    const auto &e = entries[i];
+    char macd[32];
+    std::snprintf(macd, sizeof(macd), "%d/%d/%d", e.periods.macdShort,
+                  e.periods.macdLong, e.periods.macdSignal);
+    std::printf("%4zu %5zu %4zu %10s %7d %7d %7zu %7.1f %12.2f\n", i + 1,
+                e.periods.kama, e.periods.rsi, macd, e.stats.buyCount,
+                e.stats.sellCount, e.trades,
+                e.trades ? 100.0 * e.wins / e.trades : 0.0, e.pnl);
+  }
+  return 0;
+}
@@ -0,0 +1,124 @@
+#ifndef TIMESTAMP_FORMAT_H
+#define TIMESTAMP_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+// Local "YYYY-MM-DD HH:MM:SS" text without std::localtime's shared buffer or
+// a heap allocation. Each thread caches the UTC offset and the local day it
+// last formatted, so a timestamp on that day is a few divisions; only a new
+// day calls localtime_r. The date comes from days-since-epoch with integer
+// arithmetic (Howard Hinnant's civil_from_days). A change of TZ after the
+// first call is not picked up.
+class TimestampFormat {
+public:
+  static constexpr size_t Length = 19;
+
+  // Writes up to `size` characters (no terminator); returns the length
+  // written.
+  static size_t format(std::time_t time, char *out, size_t size) {
+    Day &day = cachedDay();
+    if (time < day.start || time >= day.end) {
+      day = dayOf(time);
+    }
+    const int64_t seconds = static_cast<int64_t>(time - day.midnight);
+    char text[Length];
+    for (size_t i = 0; i < 11; ++i) {
+      text[i] = day.date[i];
+    }
+    putTwo(text + 11, static_cast<int>(seconds / 3600));
+    text[13] = ':';
+    putTwo(text + 14, static_cast<int>(seconds / 60 % 60));
+    text[16] = ':';
+    putTwo(text + 17, static_cast<int>(seconds % 60));
+
+    const size_t length = size < Length ? size : Length;
+    for (size_t i = 0; i < length; ++i) {
+      out[i] = text[i];
+    }
+    return length;
+  }
+
+  // Days since 1970-01-01 to a proleptic Gregorian date.
+  static void civilFromDays(int64_t days, int64_t &year, int &month,
+                            int &dayOfMonth) {
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const int64_t dayOfEra = days - era * 146097;
+    const int64_t yearOfEra =
+        (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) /
+        365;
+    const int64_t dayOfYear =
+        dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const int64_t monthIndex = (5 * dayOfYear + 2) / 153; // March is 0
+    dayOfMonth = static_cast<int>(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+    month = static_cast<int>(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+    year = yearOfEra + era * 400 + (month <= 2);
+  }
+
+private:
+  // [start, end) in UTC seconds share one offset and the date text;
+  // midnight is the local day's start under that offset.
+  struct Day {
+    std::time_t midnight = 0;
+    std::time_t start = 0;
+    std::time_t end = 0;
+    char date[11];
+  };
+
+  static Day &cachedDay() {
+    thread_local Day day;
+    return day;
+  }
+
+  static int64_t floorDiv(int64_t a, int64_t b) {
+    return a / b - (a % b != 0 && (a < 0) != (b < 0));
+  }
+
+  static long offsetAt(std::time_t time) {
+    std::tm timeStruct;
+    localtime_r(&time, &timeStruct);
+    return timeStruct.tm_gmtoff;
+  }
+
+  static Day dayOf(std::time_t time) {
+    const long offset = offsetAt(time);
+    const int64_t local = static_cast<int64_t>(time) + offset;
+    const int64_t days = floorDiv(local, 86400);
+
+    Day day;
+    day.midnight = static_cast<std::time_t>(days * 86400 - offset);
+    day.start = day.midnight;
+    day.end = day.midnight + 86400;
+    // On a day the offset changes (DST), only trust the quarter hour around
+    // `time`; zone transitions fall on quarter hours.
+    if (offsetAt(day.start) != offset || offsetAt(day.end - 1) != offset) {
+      const std::time_t from =
+          static_cast<std::time_t>(floorDiv(time, 900) * 900);
+      day.start = from > day.start ? from : day.start;
+      day.end = from + 900 < day.end ? from + 900 : day.end;
+    }
+
+    int64_t year;
+    int month;
+    int dayOfMonth;
+    civilFromDays(days, year, month, dayOfMonth);
+    const int64_t shown = year < 0 ? 0 : year % 10000;
+    putTwo(day.date, static_cast<int>(shown / 100));
+    putTwo(day.date + 2, static_cast<int>(shown % 100));
+    day.date[4] = '-';
+    putTwo(day.date + 5, month);
+    day.date[7] = '-';
+    putTwo(day.date + 8, dayOfMonth);
+    day.date[10] = ' ';
+    return day;
+  }
+
+  static void putTwo(char *out, int value) {
+    out[0] = static_cast<char>('0' + value / 10);
+    out[1] = static_cast<char>('0' + value % 10);
+  }
+};
+
+#endif // TIMESTAMP_FORMAT_H
@@ -0,0 +1,133 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, each with its own task deque. A worker takes
+// from the back of its own deque and, when that runs dry, steals from the
+// front of the others, so uneven tasks even out without a central queue.
+class WorkStealingPool {
+public:
+  using Task = std::function<void()>;
+
+  explicit WorkStealingPool(size_t threads = std::thread::hardware_concurrency())
+      : queues(std::max<size_t>(threads, 1)) {
+    for (auto &queue : queues) {
+      queue = std::make_unique<Queue>();
+    }
+    workers.reserve(queues.size());
+    for (size_t i = 0; i < queues.size(); ++i) {
+      workers.emplace_back(&WorkStealingPool::run, this, i);
+    }
+  }
+
+  ~WorkStealingPool() {
+    wait();
+    {
+      std::lock_guard<std::mutex> lock(idleMutex);
+      stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+  size_t size() const { return queues.size(); }
+
+  // Tasks are dealt round-robin across the workers' deques.
+  void submit(Task task) {
+    pending.fetch_add(1, std::memory_order_relaxed);
+    Queue &queue = *queues[nextQueue++ % queues.size()];
+    {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.tasks.push_back(std::move(task));
+    }
+    {
+      std::lock_guard<std::mutex> lock(idleMutex);
+      ++queued;
+    }
+    workAvailable.notify_one();
+  }
+
+  // Blocks until every submitted task has finished.
+  void wait() {
+    std::unique_lock<std::mutex> lock(idleMutex);
+    allDone.wait(lock, [this] { return pending.load() == 0; });
+  }
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void run(size_t self) {
+    for (;;) {
+      Task task;
+      {
+        std::unique_lock<std::mutex> lock(idleMutex);
+        workAvailable.wait(lock, [this] { return stopping || queued > 0; });
+        if (queued == 0) {
+          return; // stopping with nothing left
+        }
+        --queued;
+      }
+      // A task is reserved for this worker; find it, own deque first.
+      while (!take(self, task)) {
+        std::this_thread::yield();
+      }
+      task();
+      if (pending.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        allDone.notify_all();
+      }
+    }
+  }
+
+  bool take(size_t self, Task &task) {
+    {
+      Queue &own = *queues[self];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (!own.tasks.empty()) {
+        task = std::move(own.tasks.back());
+        own.tasks.pop_back();
+        return true;
+      }
+    }
+    for (size_t k = 1; k < queues.size(); ++k) {
+      Queue &victim = *queues[(self + k) % queues.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.tasks.empty()) {
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+  size_t nextQueue = 0; // submit() is called from one thread
+  std::atomic<size_t> pending{0};
+
+  std::mutex idleMutex;
+  std::condition_variable workAvailable;
+  std::condition_variable allDone;
+  size_t queued = 0; // tasks in the deques not yet claimed by a worker
+  bool stopping = false;
+};
+
+#endif // WORK_STEALING_POOL_H